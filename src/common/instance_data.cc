@@ -27,13 +27,18 @@
 
 #include "common/instance_data.h"
 
+#include <string.h>
+#include <algorithm>
+
 namespace milkcat {
 
 InstanceData::InstanceData(int string_number,
                            int integer_number,
-                           int capability): string_data_(NULL),
-                                            integer_data_(NULL),
-                                            size_(0) {
+                           int capability,
+                           int float_number): string_data_(NULL),
+                                              integer_data_(NULL),
+                                              float_data_(NULL),
+                                              size_(0) {
   if (string_number != 0) {
     string_data_ = new char **[string_number];
     for (int i = 0; i < string_number; ++i) {
@@ -51,8 +56,49 @@ InstanceData::InstanceData(int string_number,
     }
   }
 
+  if (float_number != 0) {
+    float_data_ = new float *[float_number];
+    for (int i = 0; i < float_number; ++i) {
+      float_data_[i] = new float[capability];
+    }
+  }
+
   string_number_ = string_number;
   integer_number_ = integer_number;
+  float_number_ = float_number;
+  capability_ = capability;
+}
+
+void InstanceData::Reserve(int capability) {
+  if (capability <= capability_) return;
+  capability = std::max(capability, capability_ * 2);
+
+  for (int i = 0; i < string_number_; ++i) {
+    char **string_data = new char *[capability];
+    for (int j = 0; j < capability_; ++j) {
+      string_data[j] = string_data_[i][j];
+    }
+    for (int j = capability_; j < capability; ++j) {
+      string_data[j] = new char[kFeatureLengthMax];
+    }
+    delete[] string_data_[i];
+    string_data_[i] = string_data;
+  }
+
+  for (int i = 0; i < integer_number_; ++i) {
+    int *integer_data = new int[capability];
+    memcpy(integer_data, integer_data_[i], sizeof(int) * capability_);
+    delete[] integer_data_[i];
+    integer_data_[i] = integer_data;
+  }
+
+  for (int i = 0; i < float_number_; ++i) {
+    float *float_data = new float[capability];
+    memcpy(float_data, float_data_[i], sizeof(float) * capability_);
+    delete[] float_data_[i];
+    float_data_[i] = float_data;
+  }
+
   capability_ = capability;
 }
 
@@ -73,6 +119,13 @@ InstanceData::~InstanceData() {
     }
     delete[] integer_data_;
   }
+
+  if (float_data_ != NULL) {
+    for (int i = 0; i < float_number_; ++i) {
+      delete[] float_data_[i];
+    }
+    delete[] float_data_;
+  }
 }
 
 }  // namespace milkcat
@@ -37,7 +37,10 @@ namespace milkcat {
 
 class InstanceData {
  public:
-  InstanceData(int string_number, int integer_number, int capability);
+  InstanceData(int string_number,
+               int integer_number,
+               int capability,
+               int float_number = 0);
   ~InstanceData();
 
   // Get the string of string_id at the position of this instance
@@ -46,9 +49,11 @@ class InstanceData {
     return string_data_[string_id][position];
   }
 
-  // Set the string of string_id at the position of this instance
+  // Set the string of string_id at the position of this instance, the
+  // instance grows if `position` exceeds its capability
   void set_string_at(int position, int string_id, const char *string_val) {
     assert(string_id < string_number_);
+    if (position >= capability_) Reserve(position + 1);
     strlcpy(string_data_[string_id][position], string_val, kFeatureLengthMax);
   }
 
@@ -61,20 +66,43 @@ class InstanceData {
   // Set the integer of integer_id at the position of this instance
   void set_integer_at(int position, int integer_id, int integer_val) {
     assert(integer_id < integer_number_);
+    if (position >= capability_) Reserve(position + 1);
     integer_data_[integer_id][position] = integer_val;
   }
 
+  // Get the float of float_id at the position of this instance
+  float float_at(int position, int float_id) const {
+    assert(position < size_ && float_id < float_number_);
+    return float_data_[float_id][position];
+  }
+
+  // Set the float of float_id at the position of this instance
+  void set_float_at(int position, int float_id, float float_val) {
+    assert(float_id < float_number_);
+    if (position >= capability_) Reserve(position + 1);
+    float_data_[float_id][position] = float_val;
+  }
+
   // Get the size of this instance
   int size() const { return size_; }
 
   // Set the size of this instance
-  void set_size(int size) { size_ = size; }
+  void set_size(int size) {
+    if (size > capability_) Reserve(size);
+    size_ = size;
+  }
+
+  // Makes the capability of this instance at least `capability`, it grows
+  // geometrically
+  void Reserve(int capability);
 
  private:
   char ***string_data_;
   int **integer_data_;
+  float **float_data_;
   int string_number_;
   int integer_number_;
+  int float_number_;
   int size_;
   int capability_;
 
@@ -54,6 +54,16 @@ enum {
 
 const float kDefaultCost = 6.0;
 
+// Type of the path costs in the decoders (CRF, HMM, bigram and the parser
+// beam). Costs in the models are floats already, single-precision lattices
+// take half of the memory and fill twice as many SIMD lanes. Enabled by
+// configure --enable-float-cost
+#ifdef MILKCAT_FLOAT_COST
+typedef float CostType;
+#else
+typedef double CostType;
+#endif
+
 }  // namespace milkcat
 
 #endif  // SRC_COMMON_MILKCAT_CONFIG_H_
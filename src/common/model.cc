@@ -36,6 +36,8 @@
 #include "ml/crf_model.h"
 #include "ml/hmm_model.h"
 #include "parser/feature_template.h"
+#include "util/readable_file.h"
+#include "util/writable_file.h"
 
 namespace milkcat {
 
@@ -47,24 +49,51 @@ const char *kHmmPosModelFile = "ctb_pos.hmm";
 const char *kCrfPosModelFile = "ctb_pos.crf";
 const char *kCrfSegModelFile = "ctb_seg.crf";
 const char *kOovPropertyFile = "oov_property.idx";
+const char *kOovPropertyDataFile = "oov_property.bin";
 const char *kStopwordFile = "stopword.idx";
 const char *kBeamYamadaModelPrefix = "ctb_dep.b8";
 const char *kYamadaModelPrefix = "ctb_dep.b1";
 const char *kDependenctTemplateFile = "depparse.tmpl";
 
+// The header of merged out-of-vocabulary property file is
+//   int32_t magic_number = 0x3322
+//   int32_t checksum of the unigram index
+//   int32_t size of the table
+const int32_t kOOVPropertyMagicNumber = 0x3322;
+
+namespace {
+
+// FNV-1a hash of the unigram index data, to tell if the merged
+// out-of-vocabulary property file is built from it
+int32_t IndexChecksum(const ReimuTrie *index) {
+  const uint8_t *data = static_cast<const uint8_t *>(index->array());
+  uint32_t hash = 2166136261u;
+  for (int i = 0; i < index->size(); ++i) {
+    hash ^= data[i];
+    hash *= 16777619u;
+  }
+  return static_cast<int32_t>(hash);
+}
+
+}  // namespace
+
 // ---------- Model::Impl ----------
 
 Model::Model(const char *model_dir):
     model_dir_(model_dir),
     unigram_index_(NULL),
     user_index_(NULL),
+    overlay_index_(NULL),
     unigram_cost_(NULL),
     user_cost_(NULL),
+    overlay_cost_(NULL),
     bigram_cost_(NULL),
     seg_model_(NULL),
     crf_pos_model_(NULL),
     hmm_pos_model_(NULL),
     oov_property_(NULL),
+    oov_property_by_term_id_(NULL),
+    merged_oov_property_(false),
     dependency_(NULL),
     dependency_feature_(NULL) {
   if (model_dir_.size() != 0) {
@@ -79,6 +108,12 @@ Model::~Model() {
   delete user_index_;
   user_index_ = NULL;
 
+  delete overlay_index_;
+  overlay_index_ = NULL;
+
+  delete overlay_cost_;
+  overlay_cost_ = NULL;
+
   delete unigram_index_;
   unigram_index_ = NULL;
 
@@ -103,6 +138,9 @@ Model::~Model() {
   delete oov_property_;
   oov_property_ = NULL;
 
+  delete oov_property_by_term_id_;
+  oov_property_by_term_id_ = NULL;
+
   delete dependency_;
   dependency_ = NULL;
 
@@ -170,6 +208,13 @@ void Model::ReadUserDictionary(const char *path, Status *status) {
   if (status->ok()) {
     delete user_cost_;
     user_index_ = user_index;
+
+    // Rebuilds the overlay with new user dictionary
+    delete overlay_index_;
+    overlay_index_ = NULL;
+    delete overlay_cost_;
+    overlay_cost_ = NULL;
+
     user_cost_ = StaticArray<float>::NewFromArray(
         user_cost.data(),
         static_cast<int>(user_cost.size()));
@@ -198,6 +243,64 @@ const StaticArray<float> *Model::UserCost(Status *status) {
   }
 }
 
+const ReimuTrie *Model::OverlayIndex(Status *status) {
+  if (user_index_ == NULL) return Index(status);
+  if (overlay_index_ == NULL) BuildOverlay(status);
+  return overlay_index_;
+}
+
+const StaticArray<float> *Model::OverlayUnigramCost(Status *status) {
+  if (user_index_ == NULL) return UnigramCost(status);
+  if (overlay_index_ == NULL) BuildOverlay(status);
+  return overlay_cost_;
+}
+
+void Model::BuildOverlay(Status *status) {
+  const ReimuTrie *index = NULL;
+  const StaticArray<float> *unigram_cost = NULL;
+  if (status->ok()) index = Index(status);
+  if (status->ok()) unigram_cost = UnigramCost(status);
+
+  // A writable copy of the system index
+  ReimuTrie *overlay_index = NULL;
+  if (status->ok()) {
+    std::string model_path = model_dir_ + kUnigramIndexFile;
+    overlay_index = ReimuTrie::Open(model_path.c_str());
+    if (overlay_index == NULL) {
+      std::string errmsg = "Unable to open ";
+      errmsg += model_path;
+      *status = Status::IOError(errmsg.c_str());
+    }
+  }
+
+  if (status->ok()) {
+    std::vector<float> cost(unigram_cost->size());
+    for (int term_id = 0; term_id < unigram_cost->size(); ++term_id) {
+      cost[term_id] = unigram_cost->get(term_id);
+    }
+
+    std::string word;
+    ReimuTrie::int32 user_term_id;
+    int position = 0;
+    while (user_index_->NextPair(&position, &word, &user_term_id)) {
+      float user_cost = user_cost_->get(user_term_id - kUserTermIdStart);
+      int term_id = index->Get(word.c_str(), -1);
+      if (term_id < 0) {
+        overlay_index->Put(word.c_str(), user_term_id);
+      } else if (user_cost != kDefaultCost) {
+        cost[term_id] = user_cost;
+      }
+    }
+
+    overlay_index_ = overlay_index;
+    overlay_cost_ = StaticArray<float>::NewFromArray(
+        cost.data(),
+        unigram_cost->size());
+  } else {
+    delete overlay_index;
+  }
+}
+
 const StaticArray<float> *Model::UnigramCost(Status *status) {
   if (unigram_cost_ == NULL) {
     std::string model_path = model_dir_ + kUnigramDataFile;
@@ -234,7 +337,15 @@ const CRFModel *Model::CRFPosModel(Status *status) {
 const HMMModel *Model::HMMPosModel(Status *status) {
   if (hmm_pos_model_ == NULL) {
     std::string model_path = model_dir_ + kHmmPosModelFile;
-    hmm_pos_model_ = HMMModel::New(model_path.c_str(), status);
+    HMMModel *hmm_pos_model = HMMModel::New(model_path.c_str(), status);
+
+    // The emissions of segmented words could be found by their term_id. It
+    // is optional, so ignores the error of index
+    Status index_status;
+    const ReimuTrie *index = NULL;
+    if (status->ok()) index = Index(&index_status);
+    if (index != NULL) hmm_pos_model->BuildTermIdIndex(index);
+    hmm_pos_model_ = hmm_pos_model;
   }
   return hmm_pos_model_;
 }
@@ -252,6 +363,120 @@ const ReimuTrie *Model::OOVProperty(Status *status) {
   return oov_property_;
 }
 
+StaticArray<uint8_t> *Model::BuildOOVPropertyByTermId(
+    const ReimuTrie *index,
+    const ReimuTrie *oov_property,
+    int *ignored) {
+  std::vector<uint8_t> table;
+  std::string word;
+  ReimuTrie::int32 property;
+  int position = 0;
+  if (ignored != NULL) *ignored = 0;
+  while (oov_property->NextPair(&position, &word, &property)) {
+    int term_id = index->Get(word.c_str(), -1);
+    if (term_id < 0 || term_id >= kUserTermIdStart) {
+      if (ignored != NULL) ++*ignored;
+      continue;
+    }
+
+    if (term_id >= static_cast<int>(table.size())) {
+      table.resize(term_id + 1, 0);
+    }
+    table[term_id] = static_cast<uint8_t>(property);
+  }
+  if (table.empty()) table.push_back(0);
+
+  return StaticArray<uint8_t>::NewFromArray(&table[0],
+                                            static_cast<int>(table.size()));
+}
+
+void Model::SaveOOVPropertyByTermId(const char *file_path,
+                                    const StaticArray<uint8_t> *table,
+                                    const ReimuTrie *index,
+                                    Status *status) {
+  WritableFile *fd = WritableFile::New(file_path, status);
+  if (status->ok()) {
+    fd->WriteValue<int32_t>(kOOVPropertyMagicNumber, status);
+  }
+  if (status->ok()) fd->WriteValue<int32_t>(IndexChecksum(index), status);
+  if (status->ok()) fd->WriteValue<int32_t>(table->size(), status);
+  if (status->ok()) fd->Write(table->data(), table->size(), status);
+
+  delete fd;
+}
+
+StaticArray<uint8_t> *Model::ReadOOVPropertyByTermId(const char *file_path,
+                                                     const ReimuTrie *index,
+                                                     Status *status) {
+  ReadableFile *fd = ReadableFile::New(file_path, status);
+
+  int32_t magic_number = 0;
+  if (status->ok()) fd->ReadValue<int32_t>(&magic_number, status);
+  if (status->ok() && magic_number != kOOVPropertyMagicNumber) {
+    *status = Status::Corruption(file_path);
+  }
+
+  int32_t checksum = 0;
+  if (status->ok()) fd->ReadValue<int32_t>(&checksum, status);
+  if (status->ok() && checksum != IndexChecksum(index)) {
+    std::string errmsg = file_path;
+    errmsg += " is not built from the unigram index, rebuild it by "
+              "milkcat-tools oovprop";
+    *status = Status::Corruption(errmsg.c_str());
+  }
+
+  int32_t size = 0;
+  if (status->ok()) fd->ReadValue<int32_t>(&size, status);
+  if (status->ok() && (size <= 0 || fd->Size() - fd->Tell() != size)) {
+    *status = Status::Corruption(file_path);
+  }
+
+  std::vector<uint8_t> table;
+  if (status->ok()) {
+    table.resize(size);
+    fd->Read(&table[0], size, status);
+  }
+
+  delete fd;
+  if (status->ok()) {
+    return StaticArray<uint8_t>::NewFromArray(&table[0], size);
+  } else {
+    return NULL;
+  }
+}
+
+const StaticArray<uint8_t> *Model::OOVPropertyByTermId(Status *status) {
+  const ReimuTrie *index = NULL;
+  if (oov_property_by_term_id_ == NULL && status->ok()) {
+    index = Index(status);
+  }
+
+  // Reads the merged file if it exists
+  if (oov_property_by_term_id_ == NULL && status->ok()) {
+    std::string model_path = model_dir_ + kOovPropertyDataFile;
+    FILE *fd = fopen(model_path.c_str(), "rb");
+    if (fd != NULL) {
+      fclose(fd);
+      oov_property_by_term_id_ = ReadOOVPropertyByTermId(model_path.c_str(),
+                                                         index,
+                                                         status);
+      merged_oov_property_ = status->ok();
+    }
+  }
+
+  // No merged file, builds it from the trie
+  const ReimuTrie *oov_property = NULL;
+  if (oov_property_by_term_id_ == NULL && status->ok()) {
+    oov_property = OOVProperty(status);
+    if (status->ok()) {
+      oov_property_by_term_id_ = BuildOOVPropertyByTermId(index,
+                                                          oov_property,
+                                                          NULL);
+    }
+  }
+  return oov_property_by_term_id_;
+}
+
 PerceptronModel *Model::YamadaModel(Status *status) {
   if (dependency_ == NULL) {
     std::string prefix = model_dir_ + kYamadaModelPrefix;
@@ -28,6 +28,7 @@
 // model.h --- Created at 2015-03-09
 //
 
+#include <stdint.h>
 #include <string>
 #include <vector>
 #include "parser/dependency_parser.h"
@@ -65,6 +66,16 @@ class Model {
   const ReimuTrie *UserIndex(Status *status);
   const StaticArray<float> *UserCost(Status *status);
 
+  // Get the index of the words in system and user dictionary. It is Index()
+  // with the user words put in, the words only in user dictionary have the
+  // term_id from kUserTermIdStart. Without user dictionary it is Index()
+  const ReimuTrie *OverlayIndex(Status *status);
+
+  // Get the unigram cost of the system words in OverlayIndex(), the costs in
+  // user dictionary override the system ones if they are not kDefaultCost.
+  // Without user dictionary it is UnigramCost()
+  const StaticArray<float> *OverlayUnigramCost(Status *status);
+
   const StaticArray<float> *UnigramCost(Status *status);
   const StaticHashTable<int64_t, float> *BigramCost(Status *status);
 
@@ -80,6 +91,37 @@ class Model {
   // Get the character's property in out-of-vocabulary word recognition
   const ReimuTrie *OOVProperty(Status *status);
 
+  // Get the out-of-vocabulary property of the words in Index(), indexed by
+  // their term_id. 0 for the words without property. It is read from the
+  // merged file (see SaveOOVPropertyByTermId) if exists, else it is built
+  // from OOVProperty()
+  const StaticArray<uint8_t> *OOVPropertyByTermId(Status *status);
+
+  // If OOVPropertyByTermId() is read from the merged file. In that case every
+  // word of OOVProperty() is in Index() and OOVProperty() is not needed
+  bool HasMergedOOVProperty() const { return merged_oov_property_; }
+
+  // Builds the out-of-vocabulary property table indexed by the term_id in
+  // `index` from the property trie `oov_property`. The words not in `index`
+  // are ignored, and their number is stored in `*ignored` if it is not NULL
+  static StaticArray<uint8_t> *BuildOOVPropertyByTermId(
+      const ReimuTrie *index,
+      const ReimuTrie *oov_property,
+      int *ignored);
+
+  // Saves the table from BuildOOVPropertyByTermId into the merged file
+  // `file_path`, with the checksum of the `index` it is built from
+  static void SaveOOVPropertyByTermId(const char *file_path,
+                                      const StaticArray<uint8_t> *table,
+                                      const ReimuTrie *index,
+                                      Status *status);
+
+  // Reads the merged file saved by SaveOOVPropertyByTermId. Sets status to
+  // Corruption if the file is not built from `index`
+  static StaticArray<uint8_t> *ReadOOVPropertyByTermId(const char *file_path,
+                                                       const ReimuTrie *index,
+                                                       Status *status);
+
   // Get the dependency model
   PerceptronModel *YamadaModel(Status *status);
   PerceptronModel *BeamYamadaModel(Status *status);
@@ -95,15 +137,23 @@ class Model {
 
   const ReimuTrie *unigram_index_;
   const ReimuTrie *user_index_;
+  const ReimuTrie *overlay_index_;
   const StaticArray<float> *unigram_cost_;
   const StaticArray<float> *user_cost_;
+  const StaticArray<float> *overlay_cost_;
   const StaticHashTable<int64_t, float> *bigram_cost_;
   const CRFModel *seg_model_;
   const CRFModel *crf_pos_model_;
   const HMMModel *hmm_pos_model_;
   const ReimuTrie *oov_property_;
+  const StaticArray<uint8_t> *oov_property_by_term_id_;
+  bool merged_oov_property_;
   PerceptronModel *dependency_;
   DependencyParser::FeatureTemplate *dependency_feature_;
+
+  // Builds `overlay_index_` and `overlay_cost_` from the system and user
+  // dictionary
+  void BuildOverlay(Status *status);
 };
 
 }  // namespace milkcat
@@ -30,6 +30,8 @@
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <algorithm>
+#include <string>
 #include <vector>
 
 #define _assert(x)
@@ -59,6 +61,7 @@ class ReimuTrie::Impl {
   bool Traverse(
       int *from, const char *key, int32 *value, int32 default_value) const;
   bool Traverse(int *from, char ch, int32 *value, int32 default_value) const;
+  bool NextPair(int *position, std::string *key, int32 *value) const;
  private:
   class Node;
   class Block;
@@ -219,6 +222,9 @@ bool ReimuTrie::Traverse(
       int *from, char ch, int32 *value, int32 default_value) const {
   return impl_->Traverse(from, ch, value, default_value);
 }
+bool ReimuTrie::NextPair(int *position, std::string *key, int32 *value) const {
+  return impl_->NextPair(position, key, value);
+}
 void *ReimuTrie::array() const { return impl_->array(); }
 
 ReimuTrie::Impl::Block::Block(): previous_(0),
@@ -376,6 +382,36 @@ bool ReimuTrie::Impl::Traverse(
   return true;
 }
 
+bool ReimuTrie::Impl::NextPair(
+    int *position, std::string *key, int32 *value) const {
+  if (array_ == NULL) return false;
+
+  for (int idx = *position + 1; idx < size_; ++idx) {
+    if (array_[idx].empty()) continue;
+
+    // Value nodes are the children with label 0
+    int from = array_[idx].check();
+    if (XOR(array_[from].base(), 0) != idx) continue;
+
+    // Collects the labels from `from` up to the root
+    key->clear();
+    while (from != 0) {
+      int parent = array_[from].check();
+      key->push_back(static_cast<char>(
+          CALC_LABEL_FROM_BASE_AND_TO(array_[parent].base(), from)));
+      from = parent;
+    }
+    std::reverse(key->begin(), key->end());
+
+    *value = array_[idx].value();
+    *position = idx;
+    return true;
+  }
+
+  *position = size_;
+  return false;
+}
+
 ReimuTrie::int32
 ReimuTrie::Impl::Get(const char *key, int32 default_value) const {
   int from = 0;
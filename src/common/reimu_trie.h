@@ -33,6 +33,8 @@
 
 #ifdef __cplusplus
 
+#include <string>
+
 namespace milkcat {
 
 // RemmuTrie is a reimplementation of the double-array trie algorithm of
@@ -62,6 +64,11 @@ class ReimuTrie {
       int *from, const char *key, int32 *value, int32 default_value) const;
   bool Traverse(int *from, char ch, int32 *value, int32 default_value) const;
 
+  // Iterates the (key, value) pairs of trie in the order of array. Sets
+  // `*position` to 0 before the first call. Returns false if there are no
+  // more pairs. A trie with external array (SetArray) has no pairs
+  bool NextPair(int *position, std::string *key, int32 *value) const;
+
   // Put `key` and `value` pair into trie.
   void Put(const char *key, int32 value);
 
@@ -0,0 +1,260 @@
+//
+// The MIT License (MIT)
+//
+// Copyright 2013-2014 The MilkCat Project Developers
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// sentence_cache.cc --- Created at 2015-03-18
+//
+
+#include "common/sentence_cache.h"
+
+#include <string.h>
+#include "parser/tree_instance.h"
+#include "segmenter/term_instance.h"
+#include "tagger/part_of_speech_tag_instance.h"
+#include "tokenizer/token_instance.h"
+#include "util/mutex.h"
+
+namespace milkcat {
+
+// The result of a sentence. For each term, `strings` has its tag and
+// dependency label ending with '\0', `integers` has its token number, type,
+// term-id, out-of-vocabulary flag and head, `floats` has the confidence of
+// the term and tag. Tags and trees are stored only when they are available.
+// The texts of terms are not stored since they are the spans of tokens
+struct SentenceCache::Entry {
+  uint64_t hash;
+  std::string key;
+  int size;
+  bool has_tag;
+  bool has_tree;
+  std::string strings;
+  std::vector<int> integers;
+  std::vector<float> floats;
+};
+
+struct SentenceCache::Shard {
+  typedef std::list<Entry> EntryList;
+
+  // Entries in the order of their last use, the most recent one first
+  EntryList entries;
+  std::map<uint64_t, EntryList::iterator> index;
+
+  Mutex *mutex;
+  int64_t hits;
+  int64_t misses;
+};
+
+SentenceCache::SentenceCache(int capacity,
+                             int shard_number,
+                             bool thread_safe) {
+  if (shard_number < 1) shard_number = 1;
+  shard_capacity_ = (capacity + shard_number - 1) / shard_number;
+  if (shard_capacity_ < 1) shard_capacity_ = 1;
+
+  for (int i = 0; i < shard_number; ++i) {
+    Shard *shard = new Shard();
+    shard->mutex = thread_safe? new Mutex(): NULL;
+    shard->hits = 0;
+    shard->misses = 0;
+    shards_.push_back(shard);
+  }
+}
+
+SentenceCache::~SentenceCache() {
+  for (std::vector<Shard *>::iterator
+       it = shards_.begin(); it != shards_.end(); ++it) {
+    delete (*it)->mutex;
+    delete *it;
+  }
+}
+
+// The key is the config followed by the text of the tokens, which
+// determines the tokens. Returns its 64-bit FNV-1a hash value
+uint64_t SentenceCache::MakeKey(int64_t config,
+                                const TokenInstance *token_instance,
+                                std::string *key) {
+  key->assign(reinterpret_cast<const char *>(&config), sizeof(config));
+  int size = token_instance->size();
+  if (size > 0) {
+    int begin = token_instance->token_offset_at(0);
+    int end = token_instance->token_offset_at(size - 1) +
+              token_instance->token_length_at(size - 1);
+    key->append(token_instance->text() + begin, end - begin);
+  }
+
+  uint64_t hash = 14695981039346656037ULL;
+  for (std::string::const_iterator
+       it = key->begin(); it != key->end(); ++it) {
+    hash ^= static_cast<unsigned char>(*it);
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+bool SentenceCache::Get(int64_t config,
+                        const TokenInstance *token_instance,
+                        TermInstance *term_instance,
+                        PartOfSpeechTagInstance *part_of_speech_tag_instance,
+                        TreeInstance *tree_instance) {
+  std::string key;
+  uint64_t hash = MakeKey(config, token_instance, &key);
+  Shard *shard = shards_[hash % shards_.size()];
+
+  MutexLock lock(shard->mutex);
+  std::map<uint64_t, Shard::EntryList::iterator>::iterator
+  it = shard->index.find(hash);
+  if (it == shard->index.end() ||
+      it->second->key != key ||
+      (part_of_speech_tag_instance != NULL && !it->second->has_tag) ||
+      (tree_instance != NULL && !it->second->has_tree)) {
+    ++shard->misses;
+    return false;
+  }
+
+  // Moves the entry to the front as the most recently used one
+  shard->entries.splice(shard->entries.begin(), shard->entries, it->second);
+  const Entry &entry = shard->entries.front();
+
+  term_instance->set_size(entry.size);
+  if (part_of_speech_tag_instance != NULL) {
+    part_of_speech_tag_instance->set_size(entry.size);
+  }
+  if (tree_instance != NULL) tree_instance->set_size(entry.size);
+
+  const char *strings = entry.strings.c_str();
+  const int *integers = entry.integers.data();
+  const float *floats = entry.floats.data();
+  int token_begin = 0;
+  for (int i = 0; i < entry.size; ++i) {
+    term_instance->set_value_at(i, token_instance, token_begin, integers[0],
+                                integers[1], integers[2]);
+    term_instance->set_confidence_at(i, floats[0]);
+    token_begin += integers[0];
+    integers += 3;
+    floats += 1;
+
+    if (entry.has_tag) {
+      if (part_of_speech_tag_instance != NULL) {
+        part_of_speech_tag_instance->set_value_at(i, strings, integers[0]);
+        part_of_speech_tag_instance->set_confidence_at(i, floats[0]);
+      }
+      strings += strlen(strings) + 1;
+      integers += 1;
+      floats += 1;
+    }
+
+    if (entry.has_tree) {
+      if (tree_instance != NULL) {
+        tree_instance->set_value_at(i, strings, integers[0]);
+      }
+      strings += strlen(strings) + 1;
+      integers += 1;
+    }
+  }
+
+  ++shard->hits;
+  return true;
+}
+
+void SentenceCache::Put(
+    int64_t config,
+    const TokenInstance *token_instance,
+    const TermInstance *term_instance,
+    const PartOfSpeechTagInstance *part_of_speech_tag_instance,
+    const TreeInstance *tree_instance) {
+  Entry entry;
+  entry.hash = MakeKey(config, token_instance, &entry.key);
+  entry.size = term_instance->size();
+  entry.has_tag = part_of_speech_tag_instance != NULL;
+  entry.has_tree = tree_instance != NULL;
+
+  for (int i = 0; i < entry.size; ++i) {
+    entry.integers.push_back(term_instance->token_number_at(i));
+    entry.integers.push_back(term_instance->term_type_at(i));
+    entry.integers.push_back(term_instance->term_id_at(i));
+    entry.floats.push_back(term_instance->confidence_at(i));
+
+    if (entry.has_tag) {
+      const char *tag = part_of_speech_tag_instance->part_of_speech_tag_at(i);
+      entry.strings.append(tag, strlen(tag) + 1);
+      entry.integers.push_back(
+          part_of_speech_tag_instance->is_out_of_vocabulary_word_at(i));
+      entry.floats.push_back(part_of_speech_tag_instance->confidence_at(i));
+    }
+
+    if (entry.has_tree) {
+      const char *label = tree_instance->dependency_type_at(i);
+      entry.strings.append(label, strlen(label) + 1);
+      entry.integers.push_back(tree_instance->head_node_at(i));
+    }
+  }
+
+  Shard *shard = shards_[entry.hash % shards_.size()];
+  MutexLock lock(shard->mutex);
+
+  // Replaces the entry with the same hash value
+  std::map<uint64_t, Shard::EntryList::iterator>::iterator
+  it = shard->index.find(entry.hash);
+  if (it != shard->index.end()) {
+    shard->entries.erase(it->second);
+    shard->index.erase(it);
+  }
+
+  // Evicts the least recently used entry when the shard is full
+  if (static_cast<int>(shard->entries.size()) >= shard_capacity_) {
+    shard->index.erase(shard->entries.back().hash);
+    shard->entries.pop_back();
+  }
+
+  shard->entries.push_front(Entry());
+  shard->entries.front().hash = entry.hash;
+  shard->entries.front().key.swap(entry.key);
+  shard->entries.front().size = entry.size;
+  shard->entries.front().has_tag = entry.has_tag;
+  shard->entries.front().has_tree = entry.has_tree;
+  shard->entries.front().strings.swap(entry.strings);
+  shard->entries.front().integers.swap(entry.integers);
+  shard->entries.front().floats.swap(entry.floats);
+  shard->index[entry.hash] = shard->entries.begin();
+}
+
+int64_t SentenceCache::hits() const {
+  int64_t hits = 0;
+  for (std::vector<Shard *>::const_iterator
+       it = shards_.begin(); it != shards_.end(); ++it) {
+    MutexLock lock((*it)->mutex);
+    hits += (*it)->hits;
+  }
+  return hits;
+}
+
+int64_t SentenceCache::misses() const {
+  int64_t misses = 0;
+  for (std::vector<Shard *>::const_iterator
+       it = shards_.begin(); it != shards_.end(); ++it) {
+    MutexLock lock((*it)->mutex);
+    misses += (*it)->misses;
+  }
+  return misses;
+}
+
+}  // namespace milkcat
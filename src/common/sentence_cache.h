@@ -0,0 +1,97 @@
+//
+// The MIT License (MIT)
+//
+// Copyright 2013-2014 The MilkCat Project Developers
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// sentence_cache.h --- Created at 2015-03-18
+//
+
+#ifndef SRC_COMMON_SENTENCE_CACHE_H_
+#define SRC_COMMON_SENTENCE_CACHE_H_
+
+#include <stdint.h>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+#include "util/util.h"
+
+namespace milkcat {
+
+class Mutex;
+class TokenInstance;
+class TermInstance;
+class PartOfSpeechTagInstance;
+class TreeInstance;
+
+// The bounded cache of parsing results, it maps the token sequence of a
+// sentence to its terms, part-of-speech tags and dependency tree. Sentences
+// are split into shards by their hash values and each shard evicts its least
+// recently used sentence when it is full
+class SentenceCache {
+ public:
+  // Creates the cache for at most `capacity` sentences in `shard_number`
+  // shards. If `thread_safe` is true each shard is guarded by a mutex, so the
+  // cache could be shared by parsers in different threads
+  SentenceCache(int capacity, int shard_number, bool thread_safe);
+  ~SentenceCache();
+
+  // Finds the sentence of `token_instance` parsed with the pipeline `config`.
+  // On hit, copies the result into the instances and returns true.
+  // `part_of_speech_tag_instance` and `tree_instance` could be NULL when they
+  // are not required
+  bool Get(int64_t config,
+           const TokenInstance *token_instance,
+           TermInstance *term_instance,
+           PartOfSpeechTagInstance *part_of_speech_tag_instance,
+           TreeInstance *tree_instance);
+
+  // Puts the result of the sentence of `token_instance` into the cache. The
+  // same NULL rules as Get() for `part_of_speech_tag_instance` and
+  // `tree_instance`
+  void Put(int64_t config,
+           const TokenInstance *token_instance,
+           const TermInstance *term_instance,
+           const PartOfSpeechTagInstance *part_of_speech_tag_instance,
+           const TreeInstance *tree_instance);
+
+  // The number of Get() calls that found or not found the sentence
+  int64_t hits() const;
+  int64_t misses() const;
+
+ private:
+  struct Entry;
+  struct Shard;
+
+  std::vector<Shard *> shards_;
+  int shard_capacity_;
+
+  // Gets the key of sentence and its hash value
+  static uint64_t MakeKey(int64_t config,
+                          const TokenInstance *token_instance,
+                          std::string *key);
+
+  DISALLOW_COPY_AND_ASSIGN(SentenceCache);
+};
+
+}  // namespace milkcat
+
+#endif  // SRC_COMMON_SENTENCE_CACHE_H_
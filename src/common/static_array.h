@@ -90,6 +90,9 @@ class StaticArray {
 
   int size() const { return size_; }
 
+  // Get the pointer of array data
+  const T *data() const { return data_; }
+
   // Save the static_array into file. On success, set status = Status::OK().
   // On failed, set status to other values
   void Save(const char *filename, Status *status) const {
@@ -67,6 +67,7 @@ class MILKCAT_API Parser: public noncopyable {
   class Impl;
   class Iterator;
   class Options;
+  class Reader;
 
   // The type of word. If the word is a Chinese word, English word or it's a
   // number or ...
@@ -94,6 +95,35 @@ class MILKCAT_API Parser: public noncopyable {
   // Parses the text and stores the result into the iterator
   void Predict(Iterator *iterator, const char *text);
 
+  // Parses `length` bytes of text without copying it, the text needs not end
+  // with NUL. It should be kept unchanged until the iterator is used up or
+  // predicted again. With GBK encoding the text is converted and copied.
+  // The text longer than 2GB is rejected: the iterator gets no word and
+  // LastError() is set, use PredictStream() for it.
+  void Predict(Iterator *iterator, const char *text, size_t length);
+
+  // Parses the text read from `reader` chunk by chunk, so the text of any
+  // size is parsed in constant memory. `reader` should be kept until the
+  // iterator is used up. Sentences longer than about 1MB are split.
+  void PredictStream(Iterator *iterator, Reader *reader);
+
+  // Releases the decoding buffers of the CRF segmenter and part-of-speech
+  // tagger. They are sized by the longest sentence parsed and grow again on
+  // demand, so it could be called after a very long sentence
+  void Trim();
+
+  // Get the number of sentences found or not found in the sentence cache,
+  // see Options::EnableSentenceCache()
+  int64_t sentence_cache_hits() const;
+  int64_t sentence_cache_misses() const;
+
+  // Get the number of sentences segmented by the mixed segmenter with the
+  // out-of-vocabulary word recognition, and the ones kept the bigram result
+  // since no out-of-vocabulary word could be found. They are 0 for other
+  // segmenters
+  int64_t oov_recognized_number() const;
+  int64_t bigram_only_number() const;
+
   // Get the instance of the implementation class, ONLY for internal usage
   Impl *impl() const { return impl_; }
 
@@ -101,6 +131,17 @@ class MILKCAT_API Parser: public noncopyable {
   Impl *impl_;
 };
 
+// The source of text for Parser::PredictStream()
+class MILKCAT_API Parser::Reader {
+ public:
+  virtual ~Reader() {}
+
+  // Reads at most `size` bytes of text into `buffer` and returns the number
+  // of bytes read, 0 at the end of text. The text could be cut at any byte,
+  // even in the middle of a character.
+  virtual int Read(char *buffer, int size) = 0;
+};
+
 // The options for the parser
 class MILKCAT_API Parser::Options {
  public:
@@ -123,6 +164,12 @@ class MILKCAT_API Parser::Options {
   void UseUnigramSegmenter();
   void UseBigramSegmenter();
 
+  // Dictionary-only maximum matching segmenters, forward and bidirectional.
+  // They are several times faster than the bigram segmenter but have no
+  // ambiguity resolution by costs and no out-of-vocabulary word recognition
+  void UseMaxMatchSegmenter();
+  void UseBiMaxMatchSegmenter();
+
   void UseMixedPOSTagger();
   void UseHMMPOSTagger();
   void UseCRFPOSTagger();
@@ -139,6 +186,30 @@ class MILKCAT_API Parser::Options {
   // Sets the user directory for word segmenter.
   void SetUserDictionary(const char *userdict_path);
 
+  // Sets the beam size of the CRF part-of-speech tagger. A small beam (e.g.
+  // 4) makes tagging faster with a little loss of accuracy. Default is 0,
+  // which means no pruning. The HMM tagger is always pruned, a `beam_size`
+  // larger than 0 replaces its default beam of 3.
+  void SetPOSTaggerBeamSize(int beam_size);
+
+  // Computes the confidence of words and part-of-speech tags by the CRF
+  // models, see Parser::Iterator::confidence(). It makes the CRF segmenter
+  // and tagger 2-3 times slower. Default is disabled.
+  void EnableConfidence();
+
+  // Keeps the `n` best segmentations of each sentence, see
+  // Parser::Iterator::alternative_number(). They are from the bigram or
+  // unigram segmenter in the same decoding, for mixed segmenter they are the
+  // segmentations before out-of-vocabulary word recognition. Other segmenters
+  // are not supported. Default is 0, which means disabled.
+  void SetSegmentationNBest(int n);
+
+  // Caches the results of at most `capacity` recent sentences, repeated
+  // sentences (e.g. titles and boilerplate text) are not parsed again. The
+  // parsers from a ParserPool share the same thread-safe cache. It is not
+  // used with SetSegmentationNBest(). Default is 0, which means disabled.
+  void EnableSentenceCache(int capacity);
+
   // Get the instance of the implementation class
   Impl *impl() const { return impl_; }
 
@@ -181,6 +252,11 @@ class MILKCAT_API ParserPool {
   // Releases all the Parser instances it creates
   void ReleaseAll();
 
+  // Get the number of sentences found or not found in the sentence cache
+  // shared by its parsers
+  int64_t sentence_cache_hits() const;
+  int64_t sentence_cache_misses() const;
+
   // Returns true when successfully initialized.
   bool ok() { return impl_ != NULL; }
 
@@ -219,6 +295,42 @@ class MILKCAT_API Parser::Iterator: public noncopyable {
   // Returns true if this word is the begin of sentence (BOS)
   bool is_begin_of_sentence() const;
 
+  // Get the byte offset of current word in the input text and the offset
+  // just after it, so the word is [begin_offset(), end_offset()) of the text.
+  // The invalid bytes are skipped and not in any word, but the range of a
+  // word joined across invalid UTF-8 bytes covers them. With GBK encoding
+  // they are the offsets in the GBK text before conversion.
+  // For Parser::PredictStream(), they are counted from the start of stream
+  int64_t begin_offset() const;
+  int64_t end_offset() const;
+
+  // Get the confidence of current word and its part-of-speech tag, the
+  // posterior probability of the word from the CRF segmenter multiplied by
+  // the one of its tag from the CRF tagger. Words or tags not from the CRF
+  // models (e.g. in-vocabulary words of bigram segmenter) have probability
+  // 1.0. Only available when Options::EnableConfidence() is set, otherwise
+  // returns 1.0
+  double confidence() const;
+
+  // Get the least confidence of words in current sentence, low-confidence
+  // sentences could be sent to further analysis
+  double sentence_confidence() const;
+
+  // Get the number of alternative segmentations of current sentence, they
+  // are the k-best segmentations in ascending order of cost. Only available
+  // when Options::SetSegmentationNBest() is set, otherwise returns 0
+  int alternative_number() const;
+
+  // Get the number of words in the `idx`-th alternative segmentation
+  int alternative_size(int idx) const;
+
+  // Get the `word_idx`-th word in the `idx`-th alternative segmentation
+  const char *alternative_word(int idx, int word_idx) const;
+
+  // Get the cost of the `idx`-th alternative segmentation, the negative log
+  // probability from the bigram or unigram model
+  double alternative_cost(int idx) const;
+
   // Get the instance of the implementation class
   Impl *impl() { return impl_; }
 
@@ -246,12 +358,16 @@ typedef struct milkcat_parseriterator_t {
   int head;
   const char *dependency_label;
   bool is_begin_of_sentence;
+  int64_t begin_offset;
+  int64_t end_offset;
   milkcat_parseriter_internal_t *it;
 } milkcat_parseriterator_t;
 
 #define MC_SEGMENTER_BIGRAM 0
 #define MC_SEGMENTER_CRF 1
 #define MC_SEGMENTER_MIXED 2
+#define MC_SEGMENTER_MAXMATCH 3
+#define MC_SEGMENTER_BIMAXMATCH 4
 
 #define MC_POSTAGGER_MIXED 0
 #define MC_POSTAGGER_CRF 1
@@ -268,6 +384,7 @@ typedef struct milkcat_parseroptions_t {
   int dependency_parser;
   const char *user_dictionary_path;
   const char *model_path;
+  int postagger_beam_size;
 } milkcat_parseroptions_t;
 
 MILKCAT_API void milkcat_parseroptions_init(
@@ -280,6 +397,14 @@ MILKCAT_API void milkcat_parser_predict(
     milkcat_parseriterator_t *parseriter,
     const char *text);
 
+// Like milkcat_parser_predict, but parses `length` bytes of text in place,
+// see Parser::Predict(Iterator *, const char *, size_t)
+MILKCAT_API void milkcat_parser_predict_n(
+    milkcat_parser_t *parser,
+    milkcat_parseriterator_t *parseriter,
+    const char *text,
+    size_t length);
+
 MILKCAT_API milkcat_parseriterator_t *milkcat_parseriterator_new(void);
 MILKCAT_API void milkcat_parseriterator_destroy(
     milkcat_parseriterator_t *parseriter);
@@ -28,15 +28,19 @@
 #include "include/milkcat.h"
 #include "libmilkcat.h"
 
+#include <limits.h>
 #include <stdio.h>
 #include <string.h>
+#include <algorithm>
 #include <string>
 #include <utility>
 #include <vector>
 #include "common/model.h"
+#include "common/sentence_cache.h"
 #include "ml/crf_tagger.h"
 #include "segmenter/bigram_segmenter.h"
 #include "segmenter/crf_segmenter.h"
+#include "segmenter/max_match_segmenter.h"
 #include "segmenter/mixed_segmenter.h"
 #include "segmenter/out_of_vocabulary_word_recognizer.h"
 #include "segmenter/term_instance.h"
@@ -67,8 +71,11 @@ Tokenizer *TokenizerFactory(int analyzer_type) {
 
 Segmenter *SegmenterFactory(Model *factory,
                             int analyzer_type,
+                            bool compute_confidence,
                             Status *status) {
   int segmenter_type = analyzer_type & kSegmenterMask;
+  CRFSegmenter *crf_segmenter = NULL;
+  MixedSegmenter *mixed_segmenter = NULL;
 
   switch (segmenter_type) {
     case kBigramSegmenter:
@@ -77,11 +84,26 @@ Segmenter *SegmenterFactory(Model *factory,
     case kUnigramSegmenter:
       return BigramSegmenter::New(factory, false, status);
 
+    case kMaxMatchSegmenter:
+      return MaxMatchSegmenter::New(factory, false, status);
+
+    case kBiMaxMatchSegmenter:
+      return MaxMatchSegmenter::New(factory, true, status);
+
     case kCrfSegmenter:
-      return CRFSegmenter::New(factory, status);
+      crf_segmenter = CRFSegmenter::New(factory, status);
+      if (crf_segmenter != NULL) {
+        crf_segmenter->crf_tagger()->set_compute_marginals(compute_confidence);
+      }
+      return crf_segmenter;
 
     case kMixedSegmenter:
-      return MixedSegmenter::New(factory, status);
+      mixed_segmenter = MixedSegmenter::New(factory, status);
+      if (mixed_segmenter != NULL) {
+        crf_segmenter = mixed_segmenter->oov_recognizer()->crf_segmenter();
+        crf_segmenter->crf_tagger()->set_compute_marginals(compute_confidence);
+      }
+      return mixed_segmenter;
 
     default:
       *status = Status::NotImplemented("Invalid segmenter type");
@@ -91,9 +113,13 @@ Segmenter *SegmenterFactory(Model *factory,
 
 PartOfSpeechTagger *PartOfSpeechTaggerFactory(Model *factory,
                                               int analyzer_type,
+                                              int beam_size,
+                                              bool compute_confidence,
                                               Status *status) {
   const CRFModel *crf_pos_model = NULL;
   const HMMModel *hmm_pos_model = NULL;
+  CRFPartOfSpeechTagger *crf_tagger = NULL;
+  HMMPartOfSpeechTagger *hmm_tagger = NULL;
   int tagger_type = analyzer_type & kPartOfSpeechTaggerMask;
 
   switch (tagger_type) {
@@ -101,26 +127,36 @@ PartOfSpeechTagger *PartOfSpeechTaggerFactory(Model *factory,
       if (status->ok()) crf_pos_model = factory->CRFPosModel(status);
 
       if (status->ok()) {
-        return CRFPartOfSpeechTagger::New(crf_pos_model, NULL, status);
-      } else {
-        return NULL;
+        crf_tagger = CRFPartOfSpeechTagger::New(crf_pos_model, NULL, status);
+      }
+      if (crf_tagger != NULL) {
+        crf_tagger->crf_tagger()->set_beam_size(beam_size);
+        crf_tagger->crf_tagger()->set_compute_marginals(compute_confidence);
       }
+      return crf_tagger;
 
     case kHmmTagger:
       if (status->ok()) {
-        return HMMPartOfSpeechTagger::New(factory, status);
-      } else {
-        return NULL;
+        hmm_tagger = HMMPartOfSpeechTagger::New(factory, status);
       }
+      if (hmm_tagger != NULL && beam_size > 0) {
+        hmm_tagger->set_beam_size(beam_size);
+      }
+      return hmm_tagger;
 
     case kMixedTagger:
       if (status->ok()) crf_pos_model = factory->CRFPosModel(status);
       if (status->ok()) hmm_pos_model = factory->HMMPosModel(status);
       if (status->ok()) {
-        return CRFPartOfSpeechTagger::New(crf_pos_model, hmm_pos_model, status);
-      } else {
-        return NULL;
+        crf_tagger = CRFPartOfSpeechTagger::New(crf_pos_model,
+                                                hmm_pos_model,
+                                                status);
+      }
+      if (crf_tagger != NULL) {
+        crf_tagger->crf_tagger()->set_beam_size(beam_size);
+        crf_tagger->crf_tagger()->set_compute_marginals(compute_confidence);
       }
+      return crf_tagger;
 
     case kNoTagger:
       return NULL;
@@ -161,19 +197,170 @@ DependencyParser *DependencyParserFactory(Model *factory,
 
 char gLastErrorMessage[kLastErrorStringMax] = "";
 
+// Gets the length of text for Parser::Impl::Predict(). The text longer than
+// INT_MAX bytes, or (INT_MAX - 1) / 2 bytes for GBK text since its UTF-8 form
+// is at most twice as long, is rejected with the error message and parsed as
+// empty
+int PredictLength(size_t length, bool use_gbk) {
+  size_t max_length = use_gbk? (INT_MAX - 1) / 2: INT_MAX;
+  if (length > max_length) {
+    strlcpy(gLastErrorMessage,
+            "Predict: text longer than 2GB, use PredictStream instead",
+            sizeof(gLastErrorMessage));
+    return 0;
+  }
+  return static_cast<int>(length);
+}
+
+// ----------------------------- GBKToUTF8Reader -----------------------------
+
+GBKToUTF8Reader::GBKToUTF8Reader(Encoding *encoding):
+    encoding_(encoding),
+    reader_(NULL),
+    end_(true),
+    rest_size_(0),
+    utf8_size_(0),
+    utf8_position_(0),
+    converted_size_(0) {
+}
+
+void GBKToUTF8Reader::Reset(Parser::Reader *reader) {
+  reader_ = reader;
+  end_ = reader == NULL;
+  rest_size_ = 0;
+  utf8_size_ = 0;
+  utf8_position_ = 0;
+  converted_size_ = 0;
+  skipped_bytes_.clear();
+}
+
+int GBKToUTF8Reader::Read(char *buffer, int size) {
+  while (utf8_position_ == utf8_size_ && !end_) ConvertChunk();
+
+  int read_size = std::min(size, utf8_size_ - utf8_position_);
+  memcpy(buffer, utf8_buffer_.data() + utf8_position_, read_size);
+  utf8_position_ += read_size;
+  return read_size;
+}
+
+void GBKToUTF8Reader::ConvertChunk() {
+  gbk_buffer_.resize(kChunkSize + 1);
+  utf8_buffer_.resize(2 * kChunkSize + 1);
+
+  int read_size = reader_->Read(gbk_buffer_.data() + rest_size_,
+                                kChunkSize - rest_size_);
+  if (read_size <= 0) {
+    end_ = true;
+    read_size = 0;
+  }
+  int gbk_size = rest_size_ + read_size;
+
+  // Finds the end of the last complete character, a lead byte is from 0x81
+  // to 0xfe
+  int complete_size = 0;
+  while (complete_size < gbk_size) {
+    unsigned char ch = static_cast<unsigned char>(gbk_buffer_[complete_size]);
+    int char_size = ch >= 0x81 && ch <= 0xfe? 2: 1;
+    if (complete_size + char_size > gbk_size) break;
+    complete_size += char_size;
+  }
+  if (end_) complete_size = gbk_size;
+
+  char rest = gbk_buffer_[complete_size];
+  gbk_buffer_[complete_size] = '\0';
+  utf8_size_ = Convert(gbk_buffer_.data(),
+                       complete_size,
+                       utf8_buffer_.data());
+  utf8_position_ = 0;
+  rest_size_ = gbk_size - complete_size;
+  if (rest_size_ > 0) gbk_buffer_[0] = rest;
+}
+
+int GBKToUTF8Reader::Convert(const char *gbk_text,
+                             int size,
+                             char *utf8_text) {
+  // Encoding stops at the first invalid byte and NUL ends its input. In
+  // these cases the characters are converted one by one, and the bytes
+  // could not be converted are skipped
+  int64_t utf8_capacity = 2 * static_cast<int64_t>(size) + 1;
+  assert(utf8_capacity <= INT_MAX);
+  if (memchr(gbk_text, '\0', size) == NULL &&
+      encoding_->GBKToUTF8(gbk_text,
+                           utf8_text,
+                           static_cast<int>(utf8_capacity))) {
+    int utf8_size = static_cast<int>(strlen(utf8_text));
+    converted_size_ += utf8_size;
+    return utf8_size;
+  }
+
+  int utf8_size = 0;
+  int position = 0;
+  char gbk_char[3];
+  while (position < size) {
+    unsigned char ch = static_cast<unsigned char>(gbk_text[position]);
+    int char_size = ch >= 0x81 && ch <= 0xfe && position + 1 < size? 2: 1;
+    gbk_char[0] = gbk_text[position];
+    gbk_char[1] = char_size == 2? gbk_text[position + 1]: '\0';
+    gbk_char[2] = '\0';
+
+    int char_utf8_size = 0;
+    if (ch != '\0' &&
+        encoding_->GBKToUTF8(gbk_char, utf8_text + utf8_size, 4)) {
+      char_utf8_size = static_cast<int>(strlen(utf8_text + utf8_size));
+    }
+
+    if (char_utf8_size > 0) {
+      utf8_size += char_utf8_size;
+      position += char_size;
+    } else {
+      // Skips one byte, the next one could be a character
+      int64_t utf8_offset = converted_size_ + utf8_size;
+      if (!skipped_bytes_.empty() &&
+          skipped_bytes_.back().first == utf8_offset) {
+        skipped_bytes_.back().second++;
+      } else {
+        skipped_bytes_.push_back(std::make_pair(utf8_offset, 1));
+      }
+      position++;
+    }
+  }
+  utf8_text[utf8_size] = '\0';
+
+  converted_size_ += utf8_size;
+  return utf8_size;
+}
+
+int64_t GBKToUTF8Reader::PopSkippedBytes(int64_t utf8_offset) {
+  int64_t skipped = 0;
+  while (!skipped_bytes_.empty() &&
+         skipped_bytes_.front().first <= utf8_offset) {
+    skipped += skipped_bytes_.front().second;
+    skipped_bytes_.pop_front();
+  }
+  return skipped;
+}
+
 // ----------------------------- Parser::Iterator -----------------------------
 
 Parser::Iterator::Impl::Impl():
     sentence_size_(0),
     current_idx_(0),
+    sentence_confidence_(1.0),
     end_(true),
     use_gbk_(false),
     segmenter_(NULL),
     postagger_(NULL),
-    dependency_parser_(NULL) {
+    dependency_parser_(NULL),
+    nbest_segmenter_(NULL),
+    nbest_(0),
+    alternative_number_(0),
+    sentence_cache_(NULL),
+    cache_config_(0),
+    gbk_offset_(0) {
   sentence_ = new SentenceInstance();
   tokenizer_ = new Tokenizer();
   encoding_ = new Encoding();
+  gbk_reader_ = new GBKToUTF8Reader(encoding_);
 }
 
 Parser::Iterator::Impl::~Impl() {
@@ -183,26 +370,41 @@ Parser::Iterator::Impl::~Impl() {
   delete tokenizer_;
   tokenizer_ = NULL;
 
+  delete gbk_reader_;
+  gbk_reader_ = NULL;
+
   delete encoding_;
   encoding_ = NULL;
+
+  for (std::vector<TermInstance *>::iterator
+       it = alternatives_.begin(); it != alternatives_.end(); ++it) {
+    delete *it;
+  }
 }
 
 void Parser::Iterator::Impl::Reset(
     Segmenter *segmenter,
     PartOfSpeechTagger *postagger,
     DependencyParser *dependency_parser,
-    bool use_gbk,
-    const char *text) {
+    BigramSegmenter *nbest_segmenter,
+    int nbest,
+    SentenceCache *sentence_cache,
+    int64_t cache_config,
+    bool use_gbk) {
   segmenter_ = segmenter;
   postagger_ = postagger;
   dependency_parser_ = dependency_parser;
+  nbest_segmenter_ = nbest_segmenter;
+  nbest_ = nbest;
+  alternative_number_ = 0;
+  sentence_cache_ = sentence_cache;
+  cache_config_ = cache_config;
 
   sentence_size_ = 0;
   current_idx_ = -1;
   end_ = false;
   use_gbk_ = use_gbk;
-
-  tokenizer_->Scan(text);
+  gbk_offset_ = 0;
 }
 
 bool Parser::Iterator::Impl::Next() {
@@ -218,31 +420,91 @@ bool Parser::Iterator::Impl::Next() {
       return false;
     }
 
-    // Word breaking
     TermInstance *term_instance = sentence_->term_instance();
-    segmenter_->Segment(term_instance, token_instance);
-
-    // Part-of-speech tagging
-    PartOfSpeechTagInstance *postag_instance;
+    PartOfSpeechTagInstance *postag_instance = NULL;
     if (postagger_ != NULL) {
       postag_instance = sentence_->part_of_speech_tag_instance();
-      postagger_->Tag(postag_instance, term_instance);
     }
+    TreeInstance *tree_instance = NULL;
+    if (dependency_parser_ != NULL) tree_instance = sentence_->tree_instance();
+
+    // Looks up the results of this sentence in cache
+    bool cached = false;
+    if (sentence_cache_ != NULL) {
+      cached = sentence_cache_->Get(cache_config_,
+                                    token_instance,
+                                    term_instance,
+                                    postag_instance,
+                                    tree_instance);
+    }
+
+    if (!cached) {
+      // Word breaking
+      segmenter_->Segment(term_instance, token_instance);
+
+      // K-best segmentations from the lattice of bigram segmenter
+      alternative_number_ = 0;
+      if (nbest_segmenter_ != NULL) {
+        while (static_cast<int>(alternatives_.size()) < nbest_) {
+          alternatives_.push_back(new TermInstance());
+        }
+        alternative_costs_.resize(nbest_);
+        alternative_number_ = nbest_segmenter_->NBest(
+            nbest_,
+            token_instance,
+            alternatives_.data(),
+            alternative_costs_.data());
+      }
+
+      // Part-of-speech tagging
+      if (postagger_ != NULL) {
+        postagger_->Tag(postag_instance, term_instance);
+      }
+
+      // Dependency parsing
+      if (dependency_parser_ != NULL) {
+        dependency_parser_->ParseSentence(tree_instance,
+                                          term_instance,
+                                          postag_instance);
+      }
 
-    // Dependency parsing
-    if (dependency_parser_ != NULL) {
-      TreeInstance *tree_instance = sentence_->tree_instance();
-      dependency_parser_->Parse(tree_instance,
-                                term_instance,
-                                postag_instance);
+      if (sentence_cache_ != NULL) {
+        sentence_cache_->Put(cache_config_,
+                             token_instance,
+                             term_instance,
+                             postag_instance,
+                             tree_instance);
+      }
     }
 
-    // Converts to GBK when needed
-    if (use_gbk_) ConvertToGBKTermInstance(term_instance);
+    // Converts to GBK when needed. The offsets of words in the GBK text are
+    // counted from the lengths of converted words and the bytes skipped by
+    // GBKToUTF8Reader, since the words of sentences cover the converted text
+    if (use_gbk_) {
+      ConvertToGBKTermInstance(term_instance);
+      for (int i = 0; i < alternative_number_; ++i) {
+        ConvertToGBKTermInstance(alternatives_[i]);
+      }
+
+      gbk_offsets_.resize(term_instance->size());
+      for (int i = 0; i < term_instance->size(); ++i) {
+        int64_t utf8_offset = token_instance->text_offset() +
+                              term_instance->term_offset_at(i);
+        gbk_offset_ += gbk_reader_->PopSkippedBytes(utf8_offset);
+        gbk_offsets_[i] = gbk_offset_;
+        gbk_offset_ += strlen(term_instance->term_text_at(i));
+      }
+    }
 
     // Reset cursor
     sentence_size_ = term_instance->size();
     current_idx_ = 0;
+
+    sentence_confidence_ = 1.0;
+    for (current_idx_ = 0; current_idx_ < sentence_size_; ++current_idx_) {
+      sentence_confidence_ = std::min(sentence_confidence_, confidence());
+    }
+    current_idx_ = 0;
   } else {
     ++current_idx_;
   }
@@ -252,18 +514,16 @@ bool Parser::Iterator::Impl::Next() {
 
 void Parser::Iterator::Impl::ConvertToGBKTermInstance(
     TermInstance *term_instance) {
-  char gbk_string[kTermLengthMax * 2];
+  // The GBK string is not longer than the UTF-8 one
+  std::vector<char> gbk_string;
   for (int idx = 0; idx < term_instance->size(); ++idx) {
+    const char *term_text = term_instance->term_text_at(idx);
+    gbk_string.resize(strlen(term_text) + 2);
     encoding_->UTF8ToGBK(
-        term_instance->term_text_at(idx),
-        gbk_string,
-        sizeof(gbk_string));
-    term_instance->set_value_at(
-        idx,
-        gbk_string,
-        term_instance->token_number_at(idx),
-        term_instance->term_type_at(idx),
-        term_instance->term_id_at(idx));
+        term_text,
+        gbk_string.data(),
+        static_cast<int>(gbk_string.size()) - 1);
+    term_instance->set_term_text_at(idx, gbk_string.data());
   }
 }
 
@@ -298,14 +558,44 @@ const char *Parser::Iterator::dependency_label() const {
 bool Parser::Iterator::is_begin_of_sentence() const {
   return impl_->is_begin_of_sentence();
 }
+int64_t Parser::Iterator::begin_offset() const {
+  return impl_->begin_offset();
+}
+int64_t Parser::Iterator::end_offset() const {
+  return impl_->end_offset();
+}
+double Parser::Iterator::confidence() const {
+  return impl_->confidence();
+}
+double Parser::Iterator::sentence_confidence() const {
+  return impl_->sentence_confidence();
+}
+int Parser::Iterator::alternative_number() const {
+  return impl_->alternative_number();
+}
+int Parser::Iterator::alternative_size(int idx) const {
+  return impl_->alternative_size(idx);
+}
+const char *Parser::Iterator::alternative_word(int idx, int word_idx) const {
+  return impl_->alternative_word(idx, word_idx);
+}
+double Parser::Iterator::alternative_cost(int idx) const {
+  return impl_->alternative_cost(idx);
+}
 
 // ----------------------------- Parser --------------------------------------
 
 Parser::Impl::Impl(): segmenter_(NULL),
+                      mixed_segmenter_(NULL),
+                      nbest_segmenter_(NULL),
+                      segmentation_nbest_(0),
                       part_of_speech_tagger_(NULL),
                       dependency_parser_(NULL),
                       model_(NULL),
                       external_model_(false),
+                      sentence_cache_(NULL),
+                      external_cache_(false),
+                      cache_config_(0),
                       use_gbk_(false),
                       utf8_buffersize_(1024) {
   utf8_buffer_ = new char[1024];
@@ -326,11 +616,18 @@ Parser::Impl::~Impl() {
     model_ = NULL;
   }
 
+  if (external_cache_ == false) {
+    delete sentence_cache_;
+    sentence_cache_ = NULL;
+  }
+
   delete[] utf8_buffer_;
   utf8_buffer_ = NULL;
 }
 
-Parser::Impl *Parser::Impl::New(const Options &options, Model *external_model) {
+Parser::Impl *Parser::Impl::New(const Options &options,
+                                Model *external_model,
+                                SentenceCache *external_cache) {
   Status status = Status::OK();
   Impl *self = new Parser::Impl();
 
@@ -360,12 +657,56 @@ Parser::Impl *Parser::Impl::New(const Options &options, Model *external_model) {
     self->segmenter_ = SegmenterFactory(
         self->model_,
         type,
+        options.impl()->compute_confidence(),
         &status);
 
+  if (status.ok() && (type & kSegmenterMask) == kMixedSegmenter) {
+    self->mixed_segmenter_ = static_cast<MixedSegmenter *>(self->segmenter_);
+  }
+
+  // Gets the bigram segmenter for k-best segmentations
+  if (status.ok() && options.impl()->segmentation_nbest() > 0) {
+    self->segmentation_nbest_ = options.impl()->segmentation_nbest();
+    switch (type & kSegmenterMask) {
+      case kBigramSegmenter:
+      case kUnigramSegmenter:
+        self->nbest_segmenter_ = static_cast<BigramSegmenter *>(
+            self->segmenter_);
+        break;
+
+      case kMixedSegmenter:
+        self->nbest_segmenter_ = static_cast<MixedSegmenter *>(
+            self->segmenter_)->bigram_segmenter();
+        break;
+
+      default:
+        status = Status::NotImplemented(
+            "K-best segmentation requires bigram, unigram or mixed segmenter");
+    }
+  }
+
+  // The sentence cache, it is not used with k-best segmentations since the
+  // alternatives are not cached
+  int cache_capacity = options.impl()->sentence_cache_capacity();
+  if (status.ok() && cache_capacity > 0 && self->nbest_segmenter_ == NULL) {
+    if (external_cache) {
+      self->external_cache_ = true;
+      self->sentence_cache_ = external_cache;
+    } else {
+      self->sentence_cache_ = new SentenceCache(cache_capacity, 1, false);
+    }
+    self->cache_config_ =
+        (static_cast<int64_t>(options.impl()->tagger_beam_size()) << 32) |
+        (static_cast<int64_t>(options.impl()->compute_confidence()) << 24) |
+        type;
+  }
+
   if (status.ok())
     self->part_of_speech_tagger_ = PartOfSpeechTaggerFactory(
         self->model_,
         type,
+        options.impl()->tagger_beam_size(),
+        options.impl()->compute_confidence(),
         &status);
 
   if (status.ok())
@@ -383,7 +724,10 @@ Parser::Impl *Parser::Impl::New(const Options &options, Model *external_model) {
   }
 }
 
-void Parser::Impl::Predict(Parser::Iterator *iterator, const char *text) {
+void Parser::Impl::Predict(Parser::Iterator *iterator,
+                           const char *text,
+                           int length,
+                           bool in_place) {
   // Ensures when dependency_parser_ exists part_of_speech_tagger_ should be
   // exist
   assert(dependency_parser_ != NULL? part_of_speech_tagger_ != NULL: true);
@@ -393,18 +737,27 @@ void Parser::Impl::Predict(Parser::Iterator *iterator, const char *text) {
 
   // Tokenization
   if (use_gbk_) {
-    // When using GBK encoding
-    int len = static_cast<int>(strlen(text));
+    // When using GBK encoding. The converted text in `utf8_buffer_` is shared
+    // by iterators, so it is always copied by the tokenizer
+    std::string gbk_text;
+    if (in_place) {
+      gbk_text.assign(text, length);
+      text = gbk_text.c_str();
+      in_place = false;
+    }
 
     // Requires enough space for utf8 string
-    int required = 2 * (len + 1);
+    int64_t required = 2 * static_cast<int64_t>(length) + 1;
+    assert(required <= INT_MAX);
     if (utf8_buffersize_ < required) {
       delete[] utf8_buffer_;
       utf8_buffer_ = new char[required];
-      utf8_buffersize_ = required;
+      utf8_buffersize_ = static_cast<int>(required);
     }
 
-    iterator_impl->encoding()->GBKToUTF8(text, utf8_buffer_, utf8_buffersize_);
+    GBKToUTF8Reader *gbk_reader = iterator_impl->gbk_reader();
+    gbk_reader->Reset(NULL);
+    length = gbk_reader->Convert(text, length, utf8_buffer_);
     text = utf8_buffer_;
   }
 
@@ -412,8 +765,42 @@ void Parser::Impl::Predict(Parser::Iterator *iterator, const char *text) {
       segmenter_,
       part_of_speech_tagger_,
       dependency_parser_,
-      use_gbk_,
-      text);
+      nbest_segmenter_,
+      segmentation_nbest_,
+      sentence_cache_,
+      cache_config_,
+      use_gbk_);
+  if (in_place) {
+    iterator_impl->tokenizer()->ScanInPlace(text, length);
+  } else {
+    iterator_impl->tokenizer()->Scan(text, length);
+  }
+}
+
+void Parser::Impl::PredictStream(Parser::Iterator *iterator,
+                                 Parser::Reader *reader) {
+  if (iterator == NULL) return ;
+  Iterator::Impl *iterator_impl = iterator->impl();
+  iterator_impl->Reset(
+      segmenter_,
+      part_of_speech_tagger_,
+      dependency_parser_,
+      nbest_segmenter_,
+      segmentation_nbest_,
+      sentence_cache_,
+      cache_config_,
+      use_gbk_);
+
+  if (use_gbk_) {
+    iterator_impl->gbk_reader()->Reset(reader);
+    reader = iterator_impl->gbk_reader();
+  }
+  iterator_impl->tokenizer()->ScanStream(reader);
+}
+
+void Parser::Impl::Trim() {
+  if (segmenter_ != NULL) segmenter_->Trim();
+  if (part_of_speech_tagger_ != NULL) part_of_speech_tagger_->Trim();
 }
 
 Parser::~Parser() {
@@ -421,19 +808,59 @@ Parser::~Parser() {
   impl_ = NULL;
 }
 
-Parser::Parser(): impl_(Impl::New(Options(), NULL)) {
+Parser::Parser(): impl_(Impl::New(Options(), NULL, NULL)) {
 }
-Parser::Parser(const Options &options): impl_(Impl::New(options, NULL)) {
+Parser::Parser(const Options &options):
+    impl_(Impl::New(options, NULL, NULL)) {
 }
 Parser::Parser(Impl *impl): impl_(impl) {
 }
 
 void Parser::Predict(Parser::Iterator *iterator, const char *text) {
   if (impl_ == NULL) return ;
-  return impl_->Predict(iterator, text);
+  int length = PredictLength(strlen(text), impl_->use_gbk());
+  return impl_->Predict(iterator, text, length, false);
+}
+
+void Parser::Predict(Parser::Iterator *iterator,
+                     const char *text,
+                     size_t length) {
+  if (impl_ == NULL) return ;
+  return impl_->Predict(iterator,
+                        text,
+                        PredictLength(length, impl_->use_gbk()),
+                        true);
+}
+
+void Parser::PredictStream(Parser::Iterator *iterator, Reader *reader) {
+  if (impl_ == NULL) return ;
+  return impl_->PredictStream(iterator, reader);
+}
+
+void Parser::Trim() {
+  if (impl_ == NULL) return ;
+  impl_->Trim();
+}
+
+int64_t Parser::sentence_cache_hits() const {
+  if (impl_ == NULL || impl_->sentence_cache() == NULL) return 0;
+  return impl_->sentence_cache()->hits();
+}
+int64_t Parser::sentence_cache_misses() const {
+  if (impl_ == NULL || impl_->sentence_cache() == NULL) return 0;
+  return impl_->sentence_cache()->misses();
 }
 
-ParserPool::Impl::Impl(): original_parser_(NULL) {
+int64_t Parser::oov_recognized_number() const {
+  if (impl_ == NULL || impl_->mixed_segmenter() == NULL) return 0;
+  return impl_->mixed_segmenter()->oov_recognized_number();
+}
+int64_t Parser::bigram_only_number() const {
+  if (impl_ == NULL || impl_->mixed_segmenter() == NULL) return 0;
+  return impl_->mixed_segmenter()->bigram_only_number();
+}
+
+ParserPool::Impl::Impl(): original_parser_(NULL), sentence_cache_(NULL) {
 }
 
 ParserPool::Impl::~Impl() {
@@ -441,13 +868,26 @@ ParserPool::Impl::~Impl() {
 
   delete original_parser_;
   original_parser_ = NULL;
+
+  delete sentence_cache_;
+  sentence_cache_ = NULL;
 }
 
 ParserPool::Impl *ParserPool::Impl::New(const Parser::Options &options) {
   ParserPool::Impl *self = new ParserPool::Impl();
 
+  // The sentence cache shared by all parsers of this pool
+  int cache_capacity = options.impl()->sentence_cache_capacity();
+  if (cache_capacity > 0) {
+    self->sentence_cache_ = new SentenceCache(cache_capacity,
+                                              kSentenceCacheShardNumber,
+                                              true);
+  }
+
   self->options_ = options;
-  self->original_parser_ = Parser::Impl::New(options, NULL);
+  self->original_parser_ = Parser::Impl::New(options,
+                                             NULL,
+                                             self->sentence_cache_);
   if (self->original_parser_ == NULL) {
     delete self;
     return NULL;
@@ -459,7 +899,8 @@ ParserPool::Impl *ParserPool::Impl::New(const Parser::Options &options) {
 Parser *ParserPool::Impl::NewParser() {
   Parser::Impl *parser_impl = Parser::Impl::New(
       options_,
-      original_parser_->model());
+      original_parser_->model(),
+      sentence_cache_);
   assert(parser_impl);
   Parser *parser = new Parser(parser_impl);
   mass_parsers_.push_back(parser);
@@ -493,6 +934,14 @@ void ParserPool::ReleaseAll() {
   if (impl_ == NULL) return ;
   impl_->ReleaseAll();
 }
+int64_t ParserPool::sentence_cache_hits() const {
+  if (impl_ == NULL || impl_->sentence_cache() == NULL) return 0;
+  return impl_->sentence_cache()->hits();
+}
+int64_t ParserPool::sentence_cache_misses() const {
+  if (impl_ == NULL || impl_->sentence_cache() == NULL) return 0;
+  return impl_->sentence_cache()->misses();
+}
 
 Parser::Options::Options(): impl_(new Impl()) {
 }
@@ -513,7 +962,11 @@ Parser::Options::Impl::Impl():
     segmenter_type_(kMixedSegmenter),
     tagger_type_(kMixedTagger),
     parser_type_(kNoParser),
-    use_gbk_(false) {
+    use_gbk_(false),
+    tagger_beam_size_(0),
+    compute_confidence_(false),
+    segmentation_nbest_(0),
+    sentence_cache_capacity_(0) {
 }
 void Parser::Options::UseGBK() {
   impl_->UseGBK();
@@ -533,6 +986,12 @@ void Parser::Options::UseUnigramSegmenter() {
 void Parser::Options::UseBigramSegmenter() {
   impl_->UseBigramSegmenter();
 }
+void Parser::Options::UseMaxMatchSegmenter() {
+  impl_->UseMaxMatchSegmenter();
+}
+void Parser::Options::UseBiMaxMatchSegmenter() {
+  impl_->UseBiMaxMatchSegmenter();
+}
 void Parser::Options::UseMixedPOSTagger() {
   impl_->UseMixedPOSTagger();
 }
@@ -560,6 +1019,19 @@ void Parser::Options::SetModelPath(const char *model_path) {
 void Parser::Options::SetUserDictionary(const char *userdict_path) {
   impl_->SetUserDictionary(userdict_path);
 }
+void Parser::Options::SetPOSTaggerBeamSize(int beam_size) {
+  impl_->SetPOSTaggerBeamSize(beam_size);
+}
+
+void Parser::Options::EnableConfidence() {
+  impl_->EnableConfidence();
+}
+void Parser::Options::SetSegmentationNBest(int n) {
+  impl_->SetSegmentationNBest(n);
+}
+void Parser::Options::EnableSentenceCache(int capacity) {
+  impl_->EnableSentenceCache(capacity);
+}
 
 const char *LastError() {
   return gLastErrorMessage;
@@ -31,8 +31,10 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <deque>
 #include <map>
 #include <string>
+#include <utility>
 #include <vector>
 #include "common/milkcat_config.h"
 #include "include/milkcat.h"
@@ -51,6 +53,9 @@
 namespace milkcat {
 
 class Model;
+class BigramSegmenter;
+class MixedSegmenter;
+class SentenceCache;
 
 // The global error message
 extern char gLastErrorMessage[kLastErrorStringMax];
@@ -60,6 +65,9 @@ const int kSegmenterMask = 0x00000ff0;
 const int kPartOfSpeechTaggerMask = 0x000ff000;
 const int kParserMask = 0x00f00000;
 
+// Number of shards of the sentence cache shared by a ParserPool
+const int kSentenceCacheShardNumber = 16;
+
 // A factory function to create tokenizers
 Tokenizer *TokenizerFactory(int tokenizer_id);
 
@@ -67,12 +75,17 @@ Tokenizer *TokenizerFactory(int tokenizer_id);
 // Segmenter, on failed, set status != Status::OK()
 Segmenter *SegmenterFactory(Model *factory,
                             int segmenter_id,
+                            bool compute_confidence,
                             Status *status);
 
 // A factory function to create part-of-speech taggers. On success, return the
-// instance of part-of-speech tagger, on failed, set status != Status::OK()
+// instance of part-of-speech tagger, on failed, set status != Status::OK().
+// `beam_size` is the beam size of CRF tagger, 0 for no pruning. For HMM
+// tagger, 0 keeps its default beam size
 PartOfSpeechTagger *PartOfSpeechTaggerFactory(Model *factory,
                                               int part_of_speech_tagger_id,
+                                              int beam_size,
+                                              bool compute_confidence,
                                               Status *status);
 
 
@@ -91,6 +104,8 @@ enum ParserType {
   kCrfSegmenter = 0x00000010,
   kUnigramSegmenter = 0x00000020,
   kBigramSegmenter = 0x00000030,
+  kMaxMatchSegmenter = 0x00000040,
+  kBiMaxMatchSegmenter = 0x00000050,
 
   // Part-of-speech tagger type
   kMixedTagger = 0x00000000,
@@ -106,12 +121,28 @@ enum ParserType {
 
 class Parser::Impl {
  public:
-  static Impl *New(const Options &options, Model *external_model);
+  // Creates the parser. `external_model` and `external_cache` are borrowed
+  // from another instance when they are not NULL
+  static Impl *New(const Options &options,
+                   Model *external_model,
+                   SentenceCache *external_cache);
   ~Impl();
 
-  void Predict(Iterator *iterator, const char *text);
+  // Parses `length` bytes of text. If `in_place` is true, the text is not
+  // copied and should be kept until `iterator` is used up
+  void Predict(Iterator *iterator,
+               const char *text,
+               int length,
+               bool in_place);
+
+  // Parses the text from `reader`, see Parser::PredictStream()
+  void PredictStream(Iterator *iterator, Reader *reader);
+
+  // Trims the segmenter and part-of-speech tagger, see Parser::Trim()
+  void Trim();
 
   Segmenter *segmenter() const { return segmenter_; }
+  MixedSegmenter *mixed_segmenter() const { return mixed_segmenter_; }
   PartOfSpeechTagger *part_of_speech_tagger() const {
     return part_of_speech_tagger_;
   }
@@ -120,11 +151,22 @@ class Parser::Impl {
   }
 
   Model *model() { return model_; }
+  SentenceCache *sentence_cache() { return sentence_cache_; }
+  bool use_gbk() const { return use_gbk_; }
 
  private:
   Impl();
 
   Segmenter *segmenter_;
+
+  // It is `segmenter_` when the mixed segmenter is used, else NULL
+  MixedSegmenter *mixed_segmenter_;
+
+  // The bigram segmenter for the k-best segmentations, it is `segmenter_` or
+  // the one inside it. NULL if k-best segmentations are not required
+  BigramSegmenter *nbest_segmenter_;
+  int segmentation_nbest_;
+
   PartOfSpeechTagger *part_of_speech_tagger_;
   DependencyParser *dependency_parser_;
   Model *model_;
@@ -133,6 +175,12 @@ class Parser::Impl {
   // Parser::Impl instance
   bool external_model_;
 
+  // The cache of sentence results and the value of pipeline config for it,
+  // NULL if the cache is disabled
+  SentenceCache *sentence_cache_;
+  bool external_cache_;
+  int64_t cache_config_;
+
   // These fields are used when using gbk encoding
   bool use_gbk_;
   char *utf8_buffer_;
@@ -148,8 +196,11 @@ class ParserPool::Impl {
   Parser *NewParser();
   void ReleaseAll();
 
+  SentenceCache *sentence_cache() { return sentence_cache_; }
+
  private:
   Parser::Impl *original_parser_;
+  SentenceCache *sentence_cache_;
   std::vector<Parser *> mass_parsers_;
   Parser::Options options_;
 };
@@ -177,6 +228,12 @@ class Parser::Options::Impl {
   void UseBigramSegmenter() {
     segmenter_type_ = kBigramSegmenter;
   }
+  void UseMaxMatchSegmenter() {
+    segmenter_type_ = kMaxMatchSegmenter;
+  }
+  void UseBiMaxMatchSegmenter() {
+    segmenter_type_ = kBiMaxMatchSegmenter;
+  }
 
   void UseMixedPOSTagger() {
     tagger_type_ = kMixedTagger;
@@ -211,6 +268,22 @@ class Parser::Options::Impl {
     model_path_ = model_path;
   }
 
+  void SetPOSTaggerBeamSize(int beam_size) {
+    tagger_beam_size_ = beam_size;
+  }
+
+  void EnableConfidence() {
+    compute_confidence_ = true;
+  }
+
+  void SetSegmentationNBest(int n) {
+    segmentation_nbest_ = n;
+  }
+
+  void EnableSentenceCache(int capacity) {
+    sentence_cache_capacity_ = capacity;
+  }
+
   // Get the type value of current setting
   int TypeValue() const {
     return segmenter_type_ | tagger_type_ | parser_type_;
@@ -218,12 +291,20 @@ class Parser::Options::Impl {
   bool use_gbk() const { return use_gbk_; }
   const char *user_dictionary() const { return user_dictionary_.c_str(); }
   const char *model_path() const { return model_path_.c_str(); }
+  int tagger_beam_size() const { return tagger_beam_size_; }
+  bool compute_confidence() const { return compute_confidence_; }
+  int segmentation_nbest() const { return segmentation_nbest_; }
+  int sentence_cache_capacity() const { return sentence_cache_capacity_; }
 
 private:
   int segmenter_type_;
   int tagger_type_;
   int parser_type_;
   bool use_gbk_;
+  int tagger_beam_size_;
+  bool compute_confidence_;
+  int segmentation_nbest_;
+  int sentence_cache_capacity_;
   std::string user_dictionary_;
   std::string model_path_;
 };
@@ -272,6 +353,60 @@ class SentenceInstance {
   TreeInstance *tree_instance_;
 };
 
+// Reads the GBK text from another reader and converts it into UTF-8. It is
+// used by Parser::PredictStream() with GBK encoding, and its Convert() by
+// Parser::Predict(). The bytes which are not valid GBK are skipped, their
+// positions are kept to get the offsets of words in the GBK text
+class GBKToUTF8Reader: public Parser::Reader {
+ public:
+  // The size of GBK text converted at a time
+  static const int kChunkSize = 64 * 1024;
+
+  explicit GBKToUTF8Reader(Encoding *encoding);
+
+  // Starts reading from `reader`, or converting by Convert() if it is NULL
+  void Reset(Parser::Reader *reader);
+
+  // Reads the converted text of at most `size` bytes. The characters could
+  // be cut by `size`, and it returns 0 only when `reader` is ended
+  int Read(char *buffer, int size);
+
+  // Converts `size` bytes of GBK text into `utf8_text` with NUL, it needs
+  // 2 * size + 1 bytes at most, so `size` should not exceed
+  // (INT_MAX - 1) / 2. `gbk_text[size]` should be NUL. Returns the size of
+  // converted text
+  int Convert(const char *gbk_text, int size, char *utf8_text);
+
+  // Gets the number of GBK bytes skipped before the `utf8_offset`-th byte
+  // of the converted text, and forgets them. `utf8_offset` should not
+  // decrease between calls
+  int64_t PopSkippedBytes(int64_t utf8_offset);
+
+ private:
+  Encoding *encoding_;
+  Parser::Reader *reader_;
+  bool end_;
+
+  // The GBK text read from `reader_`. The first `rest_size_` bytes are the
+  // character cut by the last chunk
+  std::vector<char> gbk_buffer_;
+  int rest_size_;
+
+  // The UTF-8 text converted from the last chunk, the bytes before
+  // `utf8_position_` are read already
+  std::vector<char> utf8_buffer_;
+  int utf8_size_;
+  int utf8_position_;
+
+  // The size of text converted since Reset(), and the skipped GBK bytes as
+  // the pairs of the offset in converted text and the number of bytes
+  int64_t converted_size_;
+  std::deque<std::pair<int64_t, int> > skipped_bytes_;
+
+  // Reads a chunk from `reader_` and converts it into `utf8_buffer_`
+  void ConvertChunk();
+};
+
 // Cursor class save the internal state of the analyzing result, such as
 // the current word and current sentence.
 class Parser::Iterator::Impl {
@@ -279,12 +414,19 @@ class Parser::Iterator::Impl {
   Impl();
   ~Impl();
 
-  // Resets this iterator
+  // Resets this iterator. `nbest_segmenter` gives the `nbest` best
+  // segmentations of each sentence, NULL if they are not required. The
+  // results of sentences are looked up in `sentence_cache` with
+  // `cache_config` first, NULL if the cache is disabled. The text should be
+  // scanned by tokenizer() after Reset()
   void Reset(Segmenter *segmenter,
              PartOfSpeechTagger *postagger,
              DependencyParser *dependency_parser,
-             bool use_gbk,
-             const char *text);
+             BigramSegmenter *nbest_segmenter,
+             int nbest,
+             SentenceCache *sentence_cache,
+             int64_t cache_config,
+             bool use_gbk);
 
   // These function return the data of current position
   const char *word() const {
@@ -321,9 +463,54 @@ class Parser::Iterator::Impl {
     }
   }
   bool is_begin_of_sentence() const { return current_idx_ == 0; }
+  int64_t begin_offset() const {
+    if (end_ || current_idx_ < 0) return 0;
+    if (use_gbk_) return gbk_offsets_[current_idx_];
+    return sentence_->token_instance()->text_offset() +
+           sentence_->term_instance()->term_offset_at(current_idx_);
+  }
+  int64_t end_offset() const {
+    if (end_ || current_idx_ < 0) return 0;
+    if (use_gbk_) return begin_offset() + strlen(word());
+    return begin_offset() +
+           sentence_->term_instance()->term_length_at(current_idx_);
+  }
+  double confidence() const {
+    if (end_ || current_idx_ < 0) return 0.0;
+    double confidence = sentence_->term_instance()->confidence_at(
+        current_idx_);
+    if (postagger_) {
+      confidence *= sentence_->part_of_speech_tag_instance()
+                             ->confidence_at(current_idx_);
+    }
+    return confidence;
+  }
+  double sentence_confidence() const {
+    if (end_ || current_idx_ < 0) return 0.0;
+    return sentence_confidence_;
+  }
+
+  // The k-best segmentations of current sentence
+  int alternative_number() const {
+    if (end_ || current_idx_ < 0) return 0;
+    return alternative_number_;
+  }
+  int alternative_size(int idx) const {
+    if (idx < 0 || idx >= alternative_number()) return 0;
+    return alternatives_[idx]->size();
+  }
+  const char *alternative_word(int idx, int word_idx) const {
+    if (word_idx < 0 || word_idx >= alternative_size(idx)) return "";
+    return alternatives_[idx]->term_text_at(word_idx);
+  }
+  double alternative_cost(int idx) const {
+    if (idx < 0 || idx >= alternative_number()) return 0.0;
+    return alternative_costs_[idx];
+  }
 
   Tokenizer *tokenizer() { return tokenizer_; }
   Encoding *encoding() { return encoding_; }
+  GBKToUTF8Reader *gbk_reader() { return gbk_reader_; }
 
   // Move the cursor to next position, if end of text is reached
   // set end() to true
@@ -332,6 +519,7 @@ class Parser::Iterator::Impl {
  private:
   int sentence_size_;
   int current_idx_;
+  double sentence_confidence_;
   bool use_gbk_;
   bool end_;
 
@@ -342,6 +530,21 @@ class Parser::Iterator::Impl {
 
   SentenceInstance *sentence_;
   Encoding *encoding_;
+  GBKToUTF8Reader *gbk_reader_;
+
+  BigramSegmenter *nbest_segmenter_;
+  int nbest_;
+  int alternative_number_;
+  std::vector<TermInstance *> alternatives_;
+  std::vector<double> alternative_costs_;
+
+  SentenceCache *sentence_cache_;
+  int64_t cache_config_;
+
+  // The offsets of words of current sentence in the GBK text, and the offset
+  // of the end of words converted so far
+  std::vector<int64_t> gbk_offsets_;
+  int64_t gbk_offset_;
 
   // Converts term_instance to GBK encoding
   void ConvertToGBKTermInstance(TermInstance *term_instance);
@@ -45,6 +45,7 @@ void milkcat_parseroptions_init(milkcat_parseroptions_t *parseropt) {
   parseropt->word_segmenter = MC_SEGMENTER_MIXED;
   parseropt->part_of_speech_tagger = MC_POSTAGGER_HMM;
   parseropt->dependency_parser = MC_DEPPARSER_NONE;
+  parseropt->postagger_beam_size = 0;
 }
 
 milkcat_parser_t *milkcat_parser_new(
@@ -60,6 +61,12 @@ milkcat_parser_t *milkcat_parser_new(
     case MC_SEGMENTER_MIXED:
       option.UseMixedSegmenter();
       break;
+    case MC_SEGMENTER_MAXMATCH:
+      option.UseMaxMatchSegmenter();
+      break;
+    case MC_SEGMENTER_BIMAXMATCH:
+      option.UseBiMaxMatchSegmenter();
+      break;
     default:
       milkcat::strlcpy(milkcat::gLastErrorMessage,
                        "Invalid type of segmenter",
@@ -111,6 +118,7 @@ milkcat_parser_t *milkcat_parser_new(
   if (parseropt->user_dictionary_path) {
     option.SetUserDictionary(parseropt->user_dictionary_path);
   }
+  option.SetPOSTaggerBeamSize(parseropt->postagger_beam_size);
 
   milkcat::Parser *parser = new milkcat::Parser(option);
   if (parser == NULL) return NULL;
@@ -137,12 +145,32 @@ void milkcat_parser_predict(
   parseriter->head = 0;
   parseriter->dependency_label = "";
   parseriter->is_begin_of_sentence = false;
+  parseriter->begin_offset = 0;
+  parseriter->end_offset = 0;
+}
+
+void milkcat_parser_predict_n(
+    milkcat_parser_t *parser,
+    milkcat_parseriterator_t *parseriter,
+    const char *text,
+    size_t length) {
+  milkcat::Parser::Iterator *it = parseriter->it->iterator;
+  parser->parser->Predict(it, text, length);
+  parseriter->word = "";
+  parseriter->part_of_speech_tag = "";
+  parseriter->head = 0;
+  parseriter->dependency_label = "";
+  parseriter->is_begin_of_sentence = false;
+  parseriter->begin_offset = 0;
+  parseriter->end_offset = 0;
 }
 
 milkcat_parseriterator_t *milkcat_parseriterator_new() {
   milkcat_parseriterator_t *parseriter = new milkcat_parseriterator_t;
   parseriter->word = "";
   parseriter->part_of_speech_tag = "";
+  parseriter->begin_offset = 0;
+  parseriter->end_offset = 0;
   parseriter->it = new milkcat_parseriter_internal_t;
   parseriter->it->iterator = new milkcat::Parser::Iterator();
   return parseriter;
@@ -163,6 +191,8 @@ bool milkcat_parseriterator_next(milkcat_parseriterator_t *parseriter) {
   parseriter->head = it->head();
   parseriter->dependency_label = it->dependency_label();
   parseriter->is_begin_of_sentence = it->is_begin_of_sentence();
+  parseriter->begin_offset = it->begin_offset();
+  parseriter->end_offset = it->end_offset();
   return has_next;
 }
 
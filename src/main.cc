@@ -41,6 +41,7 @@ struct Options {
   Parser::Options parser_options;
   bool display_tag;
   bool display_type;
+  bool display_confidence;
   bool use_stdin;
   bool conll_format;
   std::string model_dir;
@@ -52,6 +53,7 @@ struct Options {
 
 Options::Options(): display_tag(true),
                     display_type(false),
+                    display_confidence(false),
                     use_stdin(false),
                     conll_format(false) {
 }
@@ -68,6 +70,8 @@ int PrintUsage() {
   printf("        crf_seg     - Use CRF segmenter.\n");
   printf("        unigram_seg - Use Unigram segmenter.\n");
   printf("        unigram_seg - Use Bigram segmenter.\n");
+  printf("        mm_seg      - Use forward maximum matching segmenter.\n");
+  printf("        bimm_seg    - Use bidirectional max-matching segmenter.\n");
   printf("        crf         - Use CRF segmenter and Part-Of-Speech tagger.\n");
   printf("        hmm         - Use CRF segmenter and HMM Part-Of-Speech tagger.\n");
   printf("        mixed       - Use Mixed CRF and HMM segmenter and Part-Of-Speech\n");
@@ -75,6 +79,7 @@ int PrintUsage() {
   printf("        mixed_seg   - Use Mixed CRF and HMM segmenter.\n");
   printf("        dep         - Use mixed segmenter and dependency parser.\n");
   printf("    -t           Display the type of word.\n");
+  printf("    -c           Display the confidence of word.\n");
   return 0;
 }
 
@@ -102,7 +107,7 @@ void GetArgs(int argc, char **argv, Options *options) {
   char last_char;
   std::string model_dir;
 
-  while ((c = getopt(argc, argv, "iu:td:m:")) != -1) {
+  while ((c = getopt(argc, argv, "iu:tcd:m:")) != -1) {
     switch (c) {
       case 'i':
         options->use_stdin = true;
@@ -125,6 +130,14 @@ void GetArgs(int argc, char **argv, Options *options) {
           options->parser_options.UseUnigramSegmenter();
           options->parser_options.NoPOSTagger();
           options->display_tag = false;
+        } else if (strcmp(optarg, "mm_seg") == 0) {
+          options->parser_options.UseMaxMatchSegmenter();
+          options->parser_options.NoPOSTagger();
+          options->display_tag = false;
+        } else if (strcmp(optarg, "bimm_seg") == 0) {
+          options->parser_options.UseBiMaxMatchSegmenter();
+          options->parser_options.NoPOSTagger();
+          options->display_tag = false;
         } else if (strcmp(optarg, "crf") == 0) {
           options->parser_options.UseCRFSegmenter();
           options->parser_options.UseCRFPOSTagger();
@@ -161,6 +174,11 @@ void GetArgs(int argc, char **argv, Options *options) {
         options->display_type = true;
         break;
 
+      case 'c':
+        options->display_confidence = true;
+        options->parser_options.EnableConfidence();
+        break;
+
       case ':':
         fprintf(stderr, "Option -%c requires an operand\n", optopt);
         exit(1);
@@ -186,11 +204,94 @@ void GetArgs(int argc, char **argv, Options *options) {
 }
 
 
+// Reads the input file for Parser::PredictStream()
+class FileReader: public Parser::Reader {
+ public:
+  explicit FileReader(FILE *fd): fd_(fd) {}
+
+  int Read(char *buffer, int size) {
+    return static_cast<int>(fread(buffer, 1, size, fd_));
+  }
+
+ private:
+  FILE *fd_;
+};
+
+// Prints the words in `it`. A line break of the input ends a line of output
+void PrintResult(Parser::Iterator *it, const Options &options) {
+  char buffer[1024];
+  int index = 0;
+  bool line_end = true;
+
+  while (it->Next()) {
+    switch (*it->word()) {
+      case '\r':
+      case '\n':
+        for (const char *p = it->word(); *p != '\0'; ++p) {
+          if (*p == '\n') {
+            fputs("\n", stdout);
+            index = 0;
+            line_end = true;
+          }
+        }
+        continue;
+      case ' ':
+        continue;
+    }
+    line_end = false;
+
+    if (!options.conll_format) {
+      fputs(it->word(), stdout);
+      if (options.display_type) {
+        fputs("_", stdout);
+        fputs(WordType(it->type()), stdout);
+      }
+
+      if (options.display_tag) {
+        fputs("/", stdout);
+        fputs(it->part_of_speech_tag(), stdout);
+      }
+
+      if (options.display_confidence) {
+        sprintf(buffer, ":%.3f", it->confidence());
+        fputs(buffer, stdout);
+      }
+
+      fputs("  ", stdout);
+
+    } else {
+      if (it->is_begin_of_sentence() && index != 0) {
+        index = 1;
+        fputs("\n", stdout);
+      } else {
+        ++index;
+      }
+
+      sprintf(buffer, "%d", index);
+      fputs(buffer, stdout);
+
+      fputs("\t", stdout);
+      fputs(it->word(), stdout);
+
+      fputs("\t", stdout);
+      fputs(it->part_of_speech_tag(), stdout);
+
+      fputs("\t", stdout);
+      sprintf(buffer, "%d", it->head());
+      fputs(buffer, stdout);
+
+      fputs("\t", stdout);
+      fputs(it->dependency_label(), stdout);
+
+      fputs("\n", stdout);
+    }
+  }
+  if (!line_end) fputs("\n", stdout);
+}
+
 int ParserMain(int argc, char **argv) {
   FILE *fd = NULL;
   Options options;
-  char buffer[1024];
-  int index = 0;
 
   GetArgs(argc, argv, &options);
 
@@ -204,8 +305,6 @@ int ParserMain(int argc, char **argv) {
     fd = stdin;
   }
 
-  char *input_buffer = new char[1048576];
-
   Parser *parser = new Parser(options.parser_options);
   Parser::Iterator *it = new Parser::Iterator();
 
@@ -215,65 +314,24 @@ int ParserMain(int argc, char **argv) {
     exit(1);
   }
 
-  while (NULL != fgets(input_buffer, 1048576, fd)) {
-    parser->Predict(it, input_buffer);
-    index = 0;
-
-    while (it->Next()) {
-      switch (*it->word()) {
-        case '\r':
-        case '\n':
-        case ' ':
-          continue;
-      }
-
-      if (!options.conll_format) {
-        fputs(it->word(), stdout);
-        if (options.display_type) {
-          fputs("_", stdout);
-          fputs(WordType(it->type()), stdout);
-        }
-
-        if (options.display_tag) {
-          fputs("/", stdout);
-          fputs(it->part_of_speech_tag(), stdout);
-        }
-
-        fputs("  ", stdout);
-
-      } else {
-        if (it->is_begin_of_sentence() && index != 0) {
-          index = 1;
-          fputs("\n", stdout);
-        } else {
-          ++index;
-        }
-
-        sprintf(buffer, "%d", index);
-        fputs(buffer, stdout);
-
-        fputs("\t", stdout);
-        fputs(it->word(), stdout);
-
-        fputs("\t", stdout);
-        fputs(it->part_of_speech_tag(), stdout);
-
-        fputs("\t", stdout);
-        sprintf(buffer, "%d", it->head());
-        fputs(buffer, stdout);
-
-        fputs("\t", stdout);
-        fputs(it->dependency_label(), stdout);
-
-        fputs("\n", stdout);
-      }
+  if (isatty(fileno(fd))) {
+    // Parses line by line to give the result of each line immediately
+    char *input_buffer = new char[1048576];
+    while (NULL != fgets(input_buffer, 1048576, fd)) {
+      // `input_buffer` is kept until the next line, no need to copy it
+      parser->Predict(it, input_buffer, strlen(input_buffer));
+      PrintResult(it, options);
     }
-    fputs("\n", stdout);
+    delete[] input_buffer;
+  } else {
+    // Files of any size are parsed in constant memory
+    FileReader reader(fd);
+    parser->PredictStream(it, &reader);
+    PrintResult(it, options);
   }
 
   delete parser;
   delete it;
-  delete[] input_buffer;
   if (!options.use_stdin) fclose(fd);
 
   return 0;
@@ -32,11 +32,14 @@
 #include <math.h>
 #include <stdint.h>
 #include <assert.h>
+#include <time.h>
 #include <unistd.h>
 #include <map>
 #include <string>
 #include <algorithm>
 #include <set>
+#include <vector>
+#include "common/model.h"
 #include "common/reimu_trie.h"
 #include "common/static_array.h"
 #include "common/static_hashtable.h"
@@ -272,6 +275,64 @@ int MakeIndexFile(int argc, char **argv) {
   return 0;
 }
 
+// Merges the out-of-vocabulary property trie into a byte array indexed by
+// the term_id of unigram index
+int MakeOOVPropertyFile(int argc, char **argv) {
+  Status status;
+
+  if (argc != 5) {
+    status = Status::Info("Usage: milkcat-tools oovprop [UNIGRAM INDEX] "
+                          "[OOV PROPERTY INDEX] [OUTPUT-FILE]");
+  }
+
+  ReimuTrie *index = NULL;
+  if (status.ok()) {
+    index = ReimuTrie::Open(argv[2]);
+    if (index == NULL) status = Status::IOError(argv[2]);
+  }
+
+  ReimuTrie *oov_property = NULL;
+  if (status.ok()) {
+    oov_property = ReimuTrie::Open(argv[3]);
+    if (oov_property == NULL) status = Status::IOError(argv[3]);
+  }
+
+  // The merged file is used without the property trie, so every word of the
+  // trie should have a term_id
+  StaticArray<uint8_t> *table = NULL;
+  int ignored = 0;
+  if (status.ok()) {
+    table = Model::BuildOOVPropertyByTermId(index, oov_property, &ignored);
+    if (ignored > 0) {
+      char ignored_str[16];
+      sprintf(ignored_str, "%d", ignored);
+      std::string errmsg = ignored_str;
+      errmsg += " words in ";
+      errmsg += argv[3];
+      errmsg += " are not in the unigram index, keep using ";
+      errmsg += argv[3];
+      errmsg += " instead";
+      status = Status::Corruption(errmsg.c_str());
+    }
+  }
+
+  if (status.ok()) {
+    Model::SaveOOVPropertyByTermId(argv[4], table, index, &status);
+  }
+
+  if (status.ok()) printf("save %d term_ids.\n", table->size());
+
+  delete table;
+  delete oov_property;
+  delete index;
+  if (status.ok()) {
+    return 0;
+  } else {
+    puts(status.what());
+    return -1;
+  }
+}
+
 int MakePerceptronFile(int argc, char **argv) {
   Status status;
 
@@ -389,9 +450,10 @@ int TestDependendyParser(int argc, char **argv) {
 }
 
 int TestPartOfSpeechTagger(int argc, char **argv) {
-  if (argc != 4) {
+  if (argc < 4) {
     fprintf(stderr,
-            "Usage: milkcat-tools postagger-test corpus_file model_file\n");
+            "Usage: milkcat-tools postagger-test corpus_file model_file "
+            "[beam_size ...]\n");
     return 1;
   }
   const char *corpus_file = argv[2];
@@ -404,17 +466,26 @@ int TestPartOfSpeechTagger(int argc, char **argv) {
   if (status.ok()) {
     tagger = CRFPartOfSpeechTagger::New(model, NULL, &status);
   }
-  double ta = 0.0;
-  if (status.ok()) {
-    ta = PartOfSpeechTagger::Test(corpus_file, tagger, &status);
-  }
 
-  if (!status.ok()) {
-    puts(status.what());
-  } else {
-    printf("TA = %5.4f\n", ta);
+  // Tests each beam size to show the tradeoff between speed and accuracy, 0
+  // is the exact Viterbi
+  std::vector<int> beam_sizes;
+  for (int i = 4; i < argc; ++i) beam_sizes.push_back(atoi(argv[i]));
+  if (beam_sizes.empty()) beam_sizes.push_back(0);
+
+  for (std::vector<int>::iterator
+       it = beam_sizes.begin(); it != beam_sizes.end() && status.ok(); ++it) {
+    tagger->crf_tagger()->set_beam_size(*it);
+    clock_t start = clock();
+    double ta = PartOfSpeechTagger::Test(corpus_file, tagger, &status);
+    double seconds = static_cast<double>(clock() - start) / CLOCKS_PER_SEC;
+    if (status.ok()) {
+      printf("beam = %d, TA = %5.4f, time = %.3fs\n", *it, ta, seconds);
+    }
   }
 
+  if (!status.ok()) puts(status.what());
+
   delete tagger;
   delete model;
 
@@ -469,9 +540,9 @@ int WapitiConvert(int argc, char **argv) {
 
 int main(int argc, char **argv) {
   if (argc < 2) {
-    fprintf(stderr, "Usage: milkcat-tools [dict|gram|perc|depparser-train|"
-                    "depparser-test|postagger-test|postagger-train|"
-                    "wapiti-conv]\n");
+    fprintf(stderr, "Usage: milkcat-tools [dict|gram|oovprop|perc|"
+                    "depparser-train|depparser-test|postagger-test|"
+                    "postagger-train|wapiti-conv]\n");
     return 1;
   }
 
@@ -481,6 +552,8 @@ int main(int argc, char **argv) {
     return milkcat::MakeIndexFile(argc, argv);
   } else if (strcmp(tool, "gram") == 0) {
     return milkcat::MakeGramModel(argc, argv);
+  } else if (strcmp(tool, "oovprop") == 0) {
+    return milkcat::MakeOOVPropertyFile(argc, argv);
   } else if (strcmp(tool, "perc") == 0) {
     return milkcat::MakePerceptronFile(argc, argv);
   } else if (strcmp(tool, "depparser-train") == 0) {
@@ -494,9 +567,9 @@ int main(int argc, char **argv) {
   } else if (strcmp(tool, "wapiti-conv") == 0) {
     return milkcat::WapitiConvert(argc, argv);
   } else {
-    fprintf(stderr, "Usage: milkcat-tools [dict|gram|perc|depparser-train|"
-                    "depparser-test|postagger-test|postagger-train|"
-                    "wapiti-conv]\n");
+    fprintf(stderr, "Usage: milkcat-tools [dict|gram|oovprop|perc|"
+                    "depparser-train|depparser-test|postagger-test|"
+                    "postagger-train|wapiti-conv]\n");
     return 1;
   }
 
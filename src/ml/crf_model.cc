@@ -65,6 +65,84 @@ int CRFModel::xid(const char *xname) const {
   return xindex_->Get(xname, -1);
 }
 
+namespace {
+
+// Parses an integer from `*pp` until `delim`, moves `*pp` after `delim`.
+// Returns false if other characters were found
+bool ParseIndex(const char **pp, char delim, int *value) {
+  const char *&p = *pp;
+  *value = 0;
+  for (; *p != delim; ++p) {
+    if (*p < '0' || *p > '9') return false;
+    *value = 10 * *value + (*p - '0');
+  }
+  ++p;
+  return true;
+}
+
+// Compiles the CRF++ template string `template_str` into `feature_template`.
+// Returns false if `template_str` is not a valid template
+bool CompileTemplate(const char *template_str,
+                     CRFModel::FeatureTemplate *feature_template) {
+  const char *p = template_str;
+  std::string literal;
+  feature_template->ops.clear();
+  while (*p) {
+    if (*p != '%') {
+      literal.push_back(*p);
+      ++p;
+      continue;
+    }
+
+    // Parse the macro "%x[row,col]"
+    if (*++p != 'x') return false;
+    if (*++p != '[') return false;
+    ++p;
+
+    int neg = 1, row, col;
+    if (*p == '-') {
+      neg = -1;
+      ++p;
+    }
+    if (!ParseIndex(&p, ',', &row)) return false;
+    if (!ParseIndex(&p, ']', &col)) return false;
+    row *= neg;
+    if (row < -CRFModel::kMaxContextSize || row > CRFModel::kMaxContextSize) {
+      return false;
+    }
+
+    CRFModel::TemplateOp op;
+    op.prefix = literal;
+    op.row = row;
+    op.column = col;
+    feature_template->ops.push_back(op);
+    literal.clear();
+  }
+  feature_template->suffix = literal;
+
+  return true;
+}
+
+}  // namespace
+
+void CRFModel::CompileTemplates(Status *status) {
+  unigram_compiled_.resize(unigram_tmpl_.size());
+  for (int i = 0; status->ok() && i < unigram_template_num(); ++i) {
+    if (!CompileTemplate(unigram_tmpl_[i].c_str(), &unigram_compiled_[i])) {
+      std::string errmsg = "invalid CRF template: " + unigram_tmpl_[i];
+      *status = Status::Corruption(errmsg.c_str());
+    }
+  }
+
+  bigram_compiled_.resize(bigram_tmpl_.size());
+  for (int i = 0; status->ok() && i < bigram_template_num(); ++i) {
+    if (!CompileTemplate(bigram_tmpl_[i].c_str(), &bigram_compiled_[i])) {
+      std::string errmsg = "invalid CRF template: " + bigram_tmpl_[i];
+      *status = Status::Corruption(errmsg.c_str());
+    }
+  }
+}
+
 CRFModel *CRFModel::OpenText(const char *text_filename,
                              const char *template_filename,
                              Status *status) {
@@ -167,6 +245,8 @@ CRFModel *CRFModel::OpenText(const char *text_filename,
   delete fd;
   fd = NULL;
 
+  if (status->ok()) self->CompileTemplates(status);
+
   if (status->ok()) {
     return self;
   } else {
@@ -297,6 +377,8 @@ CRFModel *CRFModel::New(const char *model_prefix, Status *status) {
   }
 
   delete fd;
+  if (status->ok()) self->CompileTemplates(status);
+
   if (status->ok()) {
     return self;
   } else {
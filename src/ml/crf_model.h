@@ -45,6 +45,25 @@ template<class T> class StaticArray;
 
 class CRFModel {
  public:
+  // An operation of the compiled template: appends `prefix` and then the
+  // observation at (`row`, `column`) relative to current position
+  struct TemplateOp {
+    std::string prefix;
+    int row;
+    int column;
+  };
+
+  // A CRF++ template string like "U00:%x[-1,0]/%x[0,0]" compiled into the ops
+  // ("U00:", -1, 0), ("/", 0, 0) and an empty `suffix`. So the feature string
+  // could be built without parsing the template again
+  struct FeatureTemplate {
+    std::vector<TemplateOp> ops;
+    std::string suffix;
+  };
+
+  // The maximum absolute value of row in `%x[row,col]`
+  static const int kMaxContextSize = 5;
+
   // Open a CRF++ model file
   static CRFModel *New(const char *model_path, Status *status);
   static CRFModel *OpenText(const char *text_filename,
@@ -72,12 +91,12 @@ class CRFModel {
     return -1;
   }
 
-  // Templates
-  const char *unigram_template(int index) const {
-    return unigram_tmpl_[index].c_str();
+  // Compiled templates
+  const FeatureTemplate &unigram_template(int index) const {
+    return unigram_compiled_[index];
   }
-  const char *bigram_template(int index) const {
-    return bigram_tmpl_[index].c_str();
+  const FeatureTemplate &bigram_template(int index) const {
+    return bigram_compiled_[index];
   }
   int unigram_template_num() const {
     return static_cast<int>(unigram_tmpl_.size());
@@ -106,6 +125,8 @@ class CRFModel {
   std::vector<std::string> y_;
   std::vector<std::string> unigram_tmpl_;
   std::vector<std::string> bigram_tmpl_;
+  std::vector<FeatureTemplate> unigram_compiled_;
+  std::vector<FeatureTemplate> bigram_compiled_;
   ReimuTrie *xindex_;
   StaticArray<float> *unigram_cost_;
   StaticArray<float> *bigram_cost_;
@@ -113,6 +134,10 @@ class CRFModel {
   int unigram_xsize_;
   
   CRFModel();
+
+  // Compiles `unigram_tmpl_` and `bigram_tmpl_` into `unigram_compiled_` and
+  // `bigram_compiled_`. On failed, sets status to Status::Corruption
+  void CompileTemplates(Status *status);
 };
 
 }  // namespace milkcat
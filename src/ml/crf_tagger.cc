@@ -37,42 +37,142 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <limits.h>
-#include <string>
+#include <string.h>
+#include <algorithm>
+#include <vector>
 #include "util/util.h"
 
 namespace milkcat {
 
 struct CRFTagger::Node {
-  double cost;
+  CostType cost;
   int left_tag_id;
 };
 
-const size_t kMaxContextSize = 5;
-const char *BOS[kMaxContextSize] = {"_x+1", "_x-2", "_x-3", "_x-4", "_x-#"};
-const char *EOS[kMaxContextSize] = {"_x-1", "_x+2", "_x+3", "_x+4", "_x+#"};
+inline CRFTagger::Node *CRFTagger::bucket(int position) {
+  return decode_lattice_ + position * model_->ysize();
+}
 
-CRFTagger::CRFTagger(const CRFModel *model): model_(model) {
-  for (int i = 0; i < kSequenceMax; ++i) {
-    decode_lattice_[i] = new Node[model_->ysize()];
-  }
+const char *BOS[CRFModel::kMaxContextSize] = {
+  "_x+1", "_x-2", "_x-3", "_x-4", "_x-#"
+};
+const char *EOS[CRFModel::kMaxContextSize + 1] = {
+  "_x-1", "_x+2", "_x+3", "_x+4", "_x+#", "_x+#"
+};
 
+CRFTagger::CRFTagger(const CRFModel *model): model_(model),
+                                              decode_lattice_(NULL),
+                                              capacity_(0),
+                                              compute_marginals_(false),
+                                              unigram_cache_(NULL),
+                                              viterbi_kernel_(
+                                                  kAutoViterbiKernel),
+                                              matrix_valid_(false),
+                                              beam_size_(0),
+                                              beam_state_num_(0),
+                                              fixed_decoder_(NULL) {
+  window_feature_set_ = new SequenceFeatureSet();
   transition_table_ = new TransitionTable(model);
   transition_table_->AllowAll();
 
   lattice_ = new Lattice(model);
-  for (int idx = 0; idx < kSequenceMax; ++idx) lattice_->AllowAll(idx);
+
+  int ysize = model_->ysize();
+  stride_ = (ysize + kViterbiKernelAlign - 1) /
+            kViterbiKernelAlign * kViterbiKernelAlign;
+  bigram_matrix_ = new CostType[ysize * stride_];
+  prev_cost_ = new CostType[stride_];
+  best_cost_ = new CostType[stride_];
+  best_left_ = new int[stride_];
+  beam_states_ = new int[ysize];
 }
 
 CRFTagger::~CRFTagger() {
-  for (int i = 0; i < kSequenceMax; ++i) {
-    delete[] decode_lattice_[i];
-  }
+  delete[] decode_lattice_;
+  decode_lattice_ = NULL;
 
   delete transition_table_;
   transition_table_ = NULL;
 
   delete lattice_;
   lattice_ = NULL;
+
+  delete[] unigram_cache_;
+  unigram_cache_ = NULL;
+
+  delete window_feature_set_;
+  window_feature_set_ = NULL;
+
+  delete[] bigram_matrix_;
+  bigram_matrix_ = NULL;
+  delete[] prev_cost_;
+  prev_cost_ = NULL;
+  delete[] best_cost_;
+  best_cost_ = NULL;
+  delete[] best_left_;
+  best_left_ = NULL;
+  delete[] beam_states_;
+  beam_states_ = NULL;
+}
+
+void CRFTagger::Reserve(int size) {
+  lattice_->Reserve(size);
+  if (size <= capacity_) return;
+
+  // The content of `decode_lattice_` is not kept since it is only reserved
+  // before decoding
+  int capacity = std::max(size, capacity_ * 2);
+  delete[] decode_lattice_;
+  decode_lattice_ = new Node[capacity * model_->ysize()];
+  capacity_ = capacity;
+}
+
+void CRFTagger::Trim() {
+  delete[] decode_lattice_;
+  decode_lattice_ = NULL;
+  capacity_ = 0;
+
+  std::vector<int>().swap(result_);
+  std::vector<double>().swap(marginal_);
+  std::vector<double>().swap(alpha_);
+  std::vector<double>().swap(beta_);
+  std::vector<double>().swap(unigram_weight_);
+  std::vector<double>().swap(bigram_weight_);
+  std::vector<int>().swap(weight_offset_);
+  std::vector<unsigned char>().swap(fixed_back_);
+  lattice_->Trim();
+
+  delete window_feature_set_;
+  window_feature_set_ = new SequenceFeatureSet();
+}
+
+void CRFTagger::set_viterbi_kernel(int kernel) {
+  if (ViterbiKernelSupported(kernel)) {
+    viterbi_kernel_ = kernel;
+  } else {
+    viterbi_kernel_ = kAutoViterbiKernel;
+  }
+}
+
+void CRFTagger::EnableUnigramCache() {
+  if (unigram_cache_ != NULL) return;
+
+  cache_column_.clear();
+  cacheable_templates_.clear();
+  for (int i = 0; i < model_->unigram_template_num(); ++i) {
+    if (model_->unigram_template(i).ops.size() == 1) {
+      cache_column_.push_back(cacheable_templates_.size());
+      cacheable_templates_.push_back(i);
+    } else {
+      cache_column_.push_back(-1);
+    }
+  }
+
+  int slot_size = cacheable_templates_.size() + 1;
+  unigram_cache_ = new int[kUnigramCacheSize * slot_size];
+  for (int i = 0; i < kUnigramCacheSize; ++i) {
+    unigram_cache_[i * slot_size] = -1;
+  }
 }
 
 void CRFTagger::TagRange(SequenceFeatureSet *sequence_feature_set,
@@ -82,8 +182,82 @@ void CRFTagger::TagRange(SequenceFeatureSet *sequence_feature_set,
                          int end_tag) {
   sequence_feature_set_ = sequence_feature_set;
 
-  Viterbi(begin, end, begin_tag, end_tag);
-  StoreResult(begin, end, end_tag);
+  // CalcBigramCost(end) needs the position `end`
+  Reserve(end + 1);
+
+  // `transition_table_` may be changed since last call
+  transition_table_->Compile();
+  matrix_valid_ = false;
+
+  if (fixed_decoder_ != NULL) {
+    (this->*fixed_decoder_)(begin, end, begin_tag, end_tag);
+  } else {
+    Viterbi(begin, end, begin_tag, end_tag);
+    StoreResult(begin, end, end_tag);
+  }
+
+  if (compute_marginals_) ForwardBackward(begin, end, begin_tag, end_tag);
+}
+
+void CRFTagger::TagRangeWindowed(FeatureExtractor *extractor,
+                                 int size,
+                                 int begin,
+                                 int end,
+                                 int begin_tag,
+                                 int end_tag) {
+  assert(begin >= 0 && begin < end && end <= size);
+  int context = CRFModel::kMaxContextSize;
+  SequenceFeatureSet *sequence_feature_set = window_feature_set_;
+  std::vector<int> result;
+  std::vector<double> marginal;
+
+  int position = begin;
+  while (position < end) {
+    int window_end = std::min(end, position + kWindowSize + kWindowOverlap);
+    bool last_window = window_end == end;
+
+    // Except the first window, decoding starts from the last committed
+    // position which is pinned to its tag in `lattice_`, so the transition
+    // to `position` is checked by `transition_table_` as in a single pass
+    int decode_begin = position == begin? position: position - 1;
+
+    // Extracts the window with its context. The context is clipped only at
+    // the boundary of the sequence, where BOS and EOS are expected
+    int extract_begin = std::max(0, decode_begin - context);
+    int extract_end = std::min(size, window_end + context);
+    extractor->Extract(sequence_feature_set,
+                       lattice_,
+                       extract_begin,
+                       extract_end);
+    if (decode_begin < position) {
+      lattice_->Clear(decode_begin - extract_begin);
+      lattice_->Add(decode_begin - extract_begin, result.back());
+    }
+    TagRange(sequence_feature_set,
+             decode_begin - extract_begin,
+             window_end - extract_begin,
+             position == begin? begin_tag: -1,
+             last_window? end_tag: -1);
+    if (decode_begin < position) {
+      lattice_->AllowAll(decode_begin - extract_begin);
+    }
+
+    // Keeps the overlap part for the next window except the last one
+    int commit_size = last_window? window_end - position: kWindowSize;
+    int offset = position - decode_begin;
+    result.insert(result.end(),
+                  result_.begin() + offset,
+                  result_.begin() + offset + commit_size);
+    if (compute_marginals_) {
+      marginal.insert(marginal.end(),
+                      marginal_.begin() + offset,
+                      marginal_.begin() + offset + commit_size);
+    }
+    position += commit_size;
+  }
+
+  result_.swap(result);
+  marginal_.swap(marginal);
 }
 
 void CRFTagger::Viterbi(int begin, int end, int begin_tag, int end_tag) {
@@ -91,11 +265,13 @@ void CRFTagger::Viterbi(int begin, int end, int begin_tag, int end_tag) {
   ClearBucket(begin);
   if (begin_tag != -1) CalcBeginTagBigramCost(begin, begin_tag);
   CalcUnigramCost(begin);
+  if (beam_size_ > 0) PruneStates(begin);
 
   for (int position = begin + 1; position < end; ++position) {
     // ClearBucket(position);
     CalcBigramCost(position);
     CalcUnigramCost(position);
+    if (beam_size_ > 0) PruneStates(position);
   }
 
   if (end_tag != -1) CalcBigramCost(end);
@@ -103,12 +279,12 @@ void CRFTagger::Viterbi(int begin, int end, int begin_tag, int end_tag) {
 
 void CRFTagger::StoreResult(int begin, int end, int end_tag) {
   int best_yid = 0;
-  double best_cost = -1e37;
-  const Node *last_bucket = decode_lattice_[end - 1];
+  CostType best_cost = -1e37;
+  const Node *last_bucket = bucket(end - 1);
 
   if (end_tag != -1) {
     // Have the end tag ... so find the best result from left tag of `end_tag`
-    best_yid = decode_lattice_[end][end_tag].left_tag_id;
+    best_yid = bucket(end)[end_tag].left_tag_id;
   } else {
     int y_num = lattice_->y_num(end - 1);
     for (int y_idx = 0; y_idx < y_num; ++y_idx) {
@@ -120,31 +296,165 @@ void CRFTagger::StoreResult(int begin, int end, int end_tag) {
     }
   }
 
+  result_.resize(end - begin);
   for (int position = end - 1; position >= begin; --position) {
     result_[position - begin] = best_yid;
-    best_yid = decode_lattice_[position][best_yid].left_tag_id;
+    best_yid = bucket(position)[best_yid].left_tag_id;
+  }
+}
+
+int CRFTagger::UpdateBigramWeight(int idx) {
+  int ysize = model_->ysize();
+  if (UpdateBigramMatrix(idx) || bigram_weight_.empty()) {
+    int offset = bigram_weight_.size();
+    bigram_weight_.resize(offset + ysize * ysize);
+    double *weight = &bigram_weight_[offset];
+    for (int left = 0; left < ysize; ++left) {
+      for (int right = 0; right < ysize; ++right) {
+        weight[left * ysize + right] = exp(
+            bigram_matrix_[left * stride_ + right]);
+      }
+    }
+  }
+
+  return bigram_weight_.size() - ysize * ysize;
+}
+
+void CRFTagger::ForwardBackward(int begin,
+                                int end,
+                                int begin_tag,
+                                int end_tag) {
+  int ysize = model_->ysize();
+  int size = end - begin;
+  int feature_ids[kMaxFeature], begin_feature_ids[kMaxFeature];
+  int feature_num;
+  int begin_feature_num = begin_tag >= 0?
+                          BigramFeatureAt(begin, begin_feature_ids): 0;
+  std::vector<double> cost(ysize), weight(ysize);
+  alpha_.resize(size * ysize);
+  beta_.resize(size * ysize);
+  unigram_weight_.resize(size * ysize);
+  bigram_weight_.clear();
+  weight_offset_.resize(size + 1);
+
+  // exp(unigram cost) of the states in `lattice_`, others are 0. They are
+  // scaled by the best state of each position to avoid overflow. As in
+  // Viterbi, the transition from `begin_tag` is always allowed
+  for (int position = begin; position < end; ++position) {
+    feature_num = UnigramFeatureAt(position, feature_ids);
+    double max_cost = -HUGE_VAL;
+    for (int yid = 0; yid < ysize; ++yid) cost[yid] = -HUGE_VAL;
+    for (int y_idx = 0; y_idx < lattice_->y_num(position); ++y_idx) {
+      int yid = lattice_->at(position, y_idx);
+      cost[yid] = 0.0;
+      for (int i = 0; i < feature_num; ++i) {
+        cost[yid] += model_->unigram_cost(feature_ids[i], yid);
+      }
+      for (int i = 0; position == begin && i < begin_feature_num; ++i) {
+        cost[yid] += model_->bigram_cost(begin_feature_ids[i],
+                                         begin_tag,
+                                         yid);
+      }
+      max_cost = std::max(max_cost, cost[yid]);
+    }
+    double *unigram_weight = &unigram_weight_[(position - begin) * ysize];
+    for (int yid = 0; yid < ysize; ++yid) {
+      unigram_weight[yid] = exp(cost[yid] - max_cost);
+    }
+  }
+
+  // Forward, `alpha_` of each position is normalized to sum 1
+  for (int yid = 0; yid < ysize; ++yid) alpha_[yid] = unigram_weight_[yid];
+  for (int position = begin + 1; position < end; ++position) {
+    weight_offset_[position - begin] = UpdateBigramWeight(position);
+    const double *bigram_weight = &bigram_weight_[weight_offset_[position -
+                                                                 begin]];
+    const double *prev_alpha = &alpha_[(position - begin - 1) * ysize];
+    const double *unigram_weight = &unigram_weight_[(position - begin) *
+                                                    ysize];
+    double *alpha = &alpha_[(position - begin) * ysize];
+    for (int right = 0; right < ysize; ++right) alpha[right] = 0.0;
+    for (int left = 0; left < ysize; ++left) {
+      if (prev_alpha[left] == 0.0) continue;
+      const double *row = bigram_weight + left * ysize;
+      for (int right = 0; right < ysize; ++right) {
+        alpha[right] += prev_alpha[left] * row[right];
+      }
+    }
+    double sum = 0.0;
+    for (int right = 0; right < ysize; ++right) {
+      alpha[right] *= unigram_weight[right];
+      sum += alpha[right];
+    }
+    for (int right = 0; right < ysize; ++right) alpha[right] /= sum;
+  }
+
+  // Backward, from the transition to `end_tag` if it exists. `beta_` is
+  // normalized in the same way. The bigram weights are the ones computed in
+  // forward
+  double *last_beta = &beta_[(size - 1) * ysize];
+  if (end_tag >= 0) {
+    const double *bigram_weight = &bigram_weight_[UpdateBigramWeight(end)];
+    for (int left = 0; left < ysize; ++left) {
+      last_beta[left] = bigram_weight[left * ysize + end_tag];
+    }
+  } else {
+    for (int left = 0; left < ysize; ++left) last_beta[left] = 1.0;
+  }
+  for (int position = end - 2; position >= begin; --position) {
+    const double *bigram_weight = &bigram_weight_[weight_offset_[position -
+                                                                 begin + 1]];
+    const double *next_beta = &beta_[(position - begin + 1) * ysize];
+    const double *unigram_weight = &unigram_weight_[(position - begin + 1) *
+                                                    ysize];
+    double *beta = &beta_[(position - begin) * ysize];
+    for (int right = 0; right < ysize; ++right) {
+      weight[right] = unigram_weight[right] * next_beta[right];
+    }
+    double sum = 0.0;
+    for (int left = 0; left < ysize; ++left) {
+      const double *row = bigram_weight + left * ysize;
+      beta[left] = 0.0;
+      for (int right = 0; right < ysize; ++right) {
+        beta[left] += row[right] * weight[right];
+      }
+      sum += beta[left];
+    }
+    for (int left = 0; left < ysize; ++left) beta[left] /= sum;
+  }
+
+  // The scales of `alpha_` and `beta_` are cancelled in the normalization
+  // of each position
+  marginal_.resize(size);
+  for (int i = 0; i < size; ++i) {
+    double sum = 0.0;
+    for (int yid = 0; yid < ysize; ++yid) {
+      sum += alpha_[i * ysize + yid] * beta_[i * ysize + yid];
+    }
+    int yid = result_[i];
+    marginal_[i] = alpha_[i * ysize + yid] * beta_[i * ysize + yid] / sum;
   }
 }
 
 void CRFTagger::ClearBucket(int position) {
-  memset(decode_lattice_[position], 0, sizeof(Node) * model_->ysize());
+  memset(bucket(position), 0, sizeof(Node) * model_->ysize());
 }
 
 void CRFTagger::CalcUnigramCost(int idx) {
   int feature_ids[kMaxFeature],
       feature_id;
   int feature_num = UnigramFeatureAt(idx, feature_ids);
-  double cost;
+  CostType cost;
 
   int y_num = lattice_->y_num(idx);
   for (int y_idx = 0; y_idx < y_num; ++y_idx) {
     int yid = lattice_->at(idx, y_idx);
-    cost = decode_lattice_[idx][yid].cost;
+    cost = bucket(idx)[yid].cost;
     for (int i = 0; i < feature_num; ++i) {
       feature_id = feature_ids[i];
       cost += model_->unigram_cost(feature_id, yid);
     }
-    decode_lattice_[idx][yid].cost = cost;
+    bucket(idx)[yid].cost = cost;
     // printf("Bucket Cost: %d %s %lf\n", idx,
     // model_->GetTagText(yid), cost);
   }
@@ -154,7 +464,7 @@ void CRFTagger::CalcBeginTagBigramCost(int begin, int begin_tag) {
   int feature_ids[kMaxFeature],
       feature_id;
   int feature_num = BigramFeatureAt(begin, feature_ids);
-  double cost;
+  CostType cost;
 
   int y_num = lattice_->y_num(begin);
   for (int y_idx = 0; y_idx < y_num; ++y_idx) {
@@ -164,62 +474,211 @@ void CRFTagger::CalcBeginTagBigramCost(int begin, int begin_tag) {
       feature_id = feature_ids[i];
       cost += model_->bigram_cost(feature_id, begin_tag, yid);
     }
-    decode_lattice_[begin][yid].cost = cost;
+    bucket(begin)[yid].cost = cost;
   }
 }
 
-void CRFTagger::CalcBigramCost(int idx) {
-  int feature_ids[kMaxFeature],
-      feature_id;
-  int feature_num = BigramFeatureAt(idx, feature_ids);
-  double cost, best_cost;
-  int best_tag_id = 0;
+// Compares the tag ids by their cost in `bucket`, the better one comes first
+class CRFTagger::CompareTagByCost {
+ public:
+  CompareTagByCost(const Node *bucket): bucket_(bucket) {}
+  bool operator()(int y1, int y2) const {
+    if (bucket_[y1].cost != bucket_[y2].cost)
+      return bucket_[y1].cost > bucket_[y2].cost;
+    return y1 < y2;
+  }
+ private:
+  const Node *bucket_;
+};
 
+void CRFTagger::PruneStates(int idx) {
+  // Insertion selection of the best `beam_size_` states, the beam is small
+  // so it is cheaper than a heap
+  CompareTagByCost better(bucket(idx));
   int y_num = lattice_->y_num(idx);
-  int left_y_num = lattice_->y_num(idx - 1);
+  beam_state_num_ = 0;
   for (int y_idx = 0; y_idx < y_num; ++y_idx) {
     int yid = lattice_->at(idx, y_idx);
-    best_cost = -1e37;
-    for (int left_y_idx = 0; left_y_idx < left_y_num; ++left_y_idx) {
-      int left_yid = lattice_->at(idx - 1, left_y_idx);
-      // Ignore the bigram when it is not allowed in `transition_table_`
-      if (transition_table_->transition(left_yid, yid) == false)
-        continue;
+    int i = beam_state_num_;
+    if (i == beam_size_) {
+      if (!better(yid, beam_states_[i - 1])) continue;
+      --i;
+    } else {
+      ++beam_state_num_;
+    }
+    for (; i > 0 && better(yid, beam_states_[i - 1]); --i) {
+      beam_states_[i] = beam_states_[i - 1];
+    }
+    beam_states_[i] = yid;
+  }
 
-      cost = decode_lattice_[idx - 1][left_yid].cost;
-      for (int i = 0; i < feature_num; ++i) {
-        feature_id = feature_ids[i];
-        cost += model_->bigram_cost(feature_id, left_yid, yid);
-        // printf("Arc Cost: %s %s %lf\n", model_->GetTagText(left_yid),
-        // model_->GetTagText(yid),
-        // model_->GetBigramCost(feature_id, left_yid, yid));
+  // Keeps the order of tag id, so the ties are broken as the full Viterbi
+  std::sort(beam_states_, beam_states_ + beam_state_num_);
+}
+
+void CRFTagger::BuildBigramMatrix(const int *feature_ids, int feature_num) {
+  int ysize = model_->ysize();
+  for (int left = 0; left < ysize; ++left) {
+    CostType *row = bigram_matrix_ + left * stride_;
+    for (int right = 0; right < ysize; ++right) {
+      if (transition_table_->transition(left, right)) {
+        row[right] = 0.0;
+        for (int i = 0; i < feature_num; ++i) {
+          row[right] += model_->bigram_cost(feature_ids[i], left, right);
+        }
+      } else {
+        row[right] = -HUGE_VAL;
       }
-      if (cost > best_cost) {
-        best_tag_id = left_yid;
-        best_cost = cost;
+    }
+    for (int right = ysize; right < stride_; ++right) row[right] = -HUGE_VAL;
+  }
+
+  matrix_feature_ids_.assign(feature_ids, feature_ids + feature_num);
+  matrix_valid_ = true;
+}
+
+bool CRFTagger::UpdateBigramMatrix(int idx) {
+  int feature_ids[kMaxFeature];
+  int feature_num = BigramFeatureAt(idx, feature_ids);
+
+  if (matrix_valid_ == false ||
+      matrix_feature_ids_.size() != static_cast<size_t>(feature_num) ||
+      !std::equal(feature_ids,
+                  feature_ids + feature_num,
+                  matrix_feature_ids_.begin())) {
+    BuildBigramMatrix(feature_ids, feature_num);
+    return true;
+  } else {
+    return false;
+  }
+}
+
+void CRFTagger::CalcBigramCost(int idx) {
+  int y_num = lattice_->y_num(idx);
+  if (beam_size_ > 0) {
+    // Only the states kept by PruneStates are the left states. Sums their
+    // bigram costs directly instead of building the whole matrix
+    int feature_ids[kMaxFeature];
+    int feature_num = BigramFeatureAt(idx, feature_ids);
+    const Node *left_bucket = bucket(idx - 1);
+    for (int y_idx = 0; y_idx < y_num; ++y_idx) {
+      int yid = lattice_->at(idx, y_idx);
+      CostType best_cost = -1e37;
+      int best_tag_id = 0;
+      for (int i = 0; i < beam_state_num_; ++i) {
+        int left_yid = beam_states_[i];
+        if (transition_table_->transition(left_yid, yid) == false) continue;
+
+        CostType bigram_cost = 0.0;
+        for (int j = 0; j < feature_num; ++j) {
+          bigram_cost += model_->bigram_cost(feature_ids[j], left_yid, yid);
+        }
+        CostType cost = left_bucket[left_yid].cost + bigram_cost;
+        if (cost > best_cost) {
+          best_tag_id = left_yid;
+          best_cost = cost;
+        }
+      }
+      bucket(idx)[yid].cost = best_cost;
+      bucket(idx)[yid].left_tag_id = best_tag_id;
+    }
+    return;
+  }
+
+  UpdateBigramMatrix(idx);
+
+  // States not in the lattice of `idx - 1` are -inf
+  for (int left = 0; left < stride_; ++left) prev_cost_[left] = -HUGE_VAL;
+  int left_y_num = lattice_->y_num(idx - 1);
+  for (int left_y_idx = 0; left_y_idx < left_y_num; ++left_y_idx) {
+    int left_yid = lattice_->at(idx - 1, left_y_idx);
+    prev_cost_[left_yid] = bucket(idx - 1)[left_yid].cost;
+  }
+
+  if (transition_table_->sparse()) {
+    // Only iterates the allowed left tags for each state at `idx`, it gives
+    // the same result as MaxPlus kernels
+    for (int y_idx = 0; y_idx < y_num; ++y_idx) {
+      int yid = lattice_->at(idx, y_idx);
+      int predecessor_num = transition_table_->predecessor_num(yid);
+      const int *predecessors = transition_table_->predecessors(yid);
+      CostType best_cost = -1e37;
+      int best_tag_id = 0;
+      for (int i = 0; i < predecessor_num; ++i) {
+        int left_yid = predecessors[i];
+        CostType cost = prev_cost_[left_yid] +
+                      bigram_matrix_[left_yid * stride_ + yid];
+        if (cost > best_cost) {
+          best_tag_id = left_yid;
+          best_cost = cost;
+        }
       }
+      bucket(idx)[yid].cost = best_cost;
+      bucket(idx)[yid].left_tag_id = best_tag_id;
+    }
+    return;
+  }
+
+  MaxPlus(viterbi_kernel_,
+          prev_cost_,
+          bigram_matrix_,
+          model_->ysize(),
+          stride_,
+          best_cost_,
+          best_left_);
+
+  for (int y_idx = 0; y_idx < y_num; ++y_idx) {
+    int yid = lattice_->at(idx, y_idx);
+    bucket(idx)[yid].cost = best_cost_[yid];
+    bucket(idx)[yid].left_tag_id = best_left_[yid];
+  }
+}
+
+int CRFTagger::CachedUnigramXid(int index, int column) {
+  int slot_size = cacheable_templates_.size() + 1;
+  int id = sequence_feature_set_->id_at(index);
+  int *slot = unigram_cache_ + (id % kUnigramCacheSize) * slot_size;
+
+  if (slot[0] != id) {
+    // Cache miss, expands all cacheable templates of FeatureSet at `index`
+    char feature_str[kFeatureStringMax];
+    slot[0] = id;
+    for (int i = 0; i < slot_size - 1; ++i) {
+      const CRFModel::FeatureTemplate &
+      feature_template = model_->unigram_template(cacheable_templates_[i]);
+      BuildFeature(feature_template,
+                   index - feature_template.ops[0].row,
+                   feature_str);
+      slot[i + 1] = model_->xid(feature_str);
     }
-    decode_lattice_[idx][yid].cost = best_cost;
-    decode_lattice_[idx][yid].left_tag_id = best_tag_id;
-    // printf("Arc Cost: %d %s %s %lf\n", idx, model_->GetTagText(yid),
-    // model_->GetTagText(best_tag_id), best_cost);
   }
+
+  return slot[column + 1];
 }
 
 int CRFTagger::UnigramFeatureAt(int position, int *feature_ids) {
-  const char *template_str;
+  char feature_str[kFeatureStringMax];
   int count = 0,
-      feature_id;
-  std::string feature_str;
-  bool result;
+      feature_id,
+      index;
 
   for (int i = 0; i < model_->unigram_template_num(); ++i) {
-    template_str = model_->unigram_template(i);
-    result = ApplyRule(&feature_str, template_str, position);
-    assert(result);
-    feature_id = model_->xid(feature_str.c_str());
+    const CRFModel::FeatureTemplate &
+    feature_template = model_->unigram_template(i);
+    if (unigram_cache_ != NULL && cache_column_[i] >= 0) {
+      index = position + feature_template.ops[0].row;
+      if (index >= 0 && index < sequence_feature_set_->size() &&
+          sequence_feature_set_->id_at(index) >= 0) {
+        feature_id = CachedUnigramXid(index, cache_column_[i]);
+        if (feature_id != -1) feature_ids[count++] = feature_id;
+        continue;
+      }
+    }
+
+    BuildFeature(feature_template, position, feature_str);
+    feature_id = model_->xid(feature_str);
     if (feature_id != -1) {
-      // printf("%s %d\n", feature_str.c_str(), feature_id);
+      // printf("%s %d\n", feature_str, feature_id);
       feature_ids[count++] = feature_id;
     }
   }
@@ -228,17 +687,13 @@ int CRFTagger::UnigramFeatureAt(int position, int *feature_ids) {
 }
 
 int CRFTagger::BigramFeatureAt(int position, int *feature_ids) {
-  const char *template_str;
+  char feature_str[kFeatureStringMax];
   int count = 0,
       feature_id;
-  std::string feature_str;
-  bool result;
 
   for (int i = 0; i < model_->bigram_template_num(); ++i) {
-    template_str = model_->bigram_template(i);
-    result = ApplyRule(&feature_str, template_str, position);
-    assert(result);
-    feature_id = model_->xid(feature_str.c_str());
+    BuildFeature(model_->bigram_template(i), position, feature_str);
+    feature_id = model_->xid(feature_str);
     if (feature_id != -1) {
       feature_ids[count++] = feature_id;
     }
@@ -247,115 +702,93 @@ int CRFTagger::BigramFeatureAt(int position, int *feature_ids) {
   return count;
 }
 
-const char *CRFTagger::GetIndex(const char **pp, int position) {
-  const char *&p = *pp;
-  if (*p++ !='[') {
-    return 0;
+const char *CRFTagger::Observation(int position, int column) {
+  if (position < 0) {
+    return BOS[-position - 1];
   }
-
-  int col = 0;
-  int row = 0;
-
-  int neg = 1;
-  if (*p++ == '-') {
-    neg = -1;
-  } else {
-    --p;
-  }
-
-  for (; *p; ++p) {
-    switch (*p) {
-      case '0': case '1': case '2': case '3': case '4':
-      case '5': case '6': case '7': case '8': case '9':
-        row = 10 * row +(*p - '0');
-        break;
-      case ',':
-        ++p;
-        goto NEXT1;
-      default: return  0;
-    }
+  if (position >= sequence_feature_set_->size()) {
+    return EOS[position - sequence_feature_set_->size()];
   }
 
-NEXT1:
-  for (; *p; ++p) {
-    switch (*p) {
-      case '0': case '1': case '2': case '3': case '4':
-      case '5': case '6': case '7': case '8': case '9':
-        col = 10 * col + (*p - '0');
-        break;
-      case ']': goto NEXT2;
-      default: return 0;
-    }
-  }
+  return sequence_feature_set_->at_index(position)->at(column);
+}
 
-NEXT2:
-  row *= neg;
-
-  if (row < -static_cast<int>(kMaxContextSize) ||
-      row > static_cast<int>(kMaxContextSize) ||
-      col < 0) {
-    return 0;
-  }
-
-  const int idx = position + row;
-  if (idx < 0) {
-    return BOS[-idx-1];
-  }
-  if (idx >= static_cast<int>(sequence_feature_set_->size())) {
-    return EOS[idx - sequence_feature_set_->size()];
-  }
-
-  return sequence_feature_set_->at_index(idx)->at(col);
-}
-
-bool CRFTagger::ApplyRule(std::string *output_str,
-                          const char *template_str,
-                          size_t position) {
-  const char *p = template_str,
-             *index_str;
-  output_str->clear();
-  for (; *p; p++) {
-    switch (*p) {
-      default:
-        output_str->push_back(*p);
-        break;
-      case '%':
-        switch (*++p) {
-          case 'x':
-            ++p;
-            index_str = GetIndex(&p, static_cast<int>(position));
-            if (!index_str) {
-              return false;
-            }
-            output_str->append(index_str);
-            break;
-          default:
-            return false;
-        }
-        break;
-    }
+void CRFTagger::BuildFeature(const CRFModel::FeatureTemplate &feature_template,
+                             int position,
+                             char *buffer) {
+  // Reserves one byte for the tailing '\0'
+  char *p = buffer, *end = buffer + kFeatureStringMax - 1;
+  int size;
+
+  for (std::vector<CRFModel::TemplateOp>::const_iterator
+       it = feature_template.ops.begin();
+       it != feature_template.ops.end();
+       ++it) {
+    size = std::min(static_cast<int>(it->prefix.size()),
+                    static_cast<int>(end - p));
+    memcpy(p, it->prefix.data(), size);
+    p += size;
+
+    const char *observation = Observation(position + it->row, it->column);
+    while (*observation && p < end) *p++ = *observation++;
   }
-  return true;
+
+  size = std::min(static_cast<int>(feature_template.suffix.size()),
+                  static_cast<int>(end - p));
+  memcpy(p, feature_template.suffix.data(), size);
+  p += size;
+  *p = '\0';
 }
 
 CRFTagger::TransitionTable::TransitionTable(const CRFModel *model):
+    allowed_num_(0),
+    compiled_(false),
     model_(model) {
   ysize_ = model->ysize();
   transition_ = new bool[ysize_ * ysize_];
+  predecessors_ = new int[ysize_ * ysize_];
+  predecessor_num_ = new int[ysize_];
   AllowAll();
+  Compile();
 }
 CRFTagger::TransitionTable::~TransitionTable() {
   delete[] transition_;
   transition_ = NULL;
+
+  delete[] predecessors_;
+  predecessors_ = NULL;
+
+  delete[] predecessor_num_;
+  predecessor_num_ = NULL;
 }
 
 void CRFTagger::TransitionTable::Allow(int left, int right) {
   assert(left < ysize_ && right < ysize_);
   transition_[left * ysize_ + right] = true;
+  compiled_ = false;
 }
 void CRFTagger::TransitionTable::Disallow(int left, int right) {
   assert(left < ysize_ && right < ysize_);
   transition_[left * ysize_ + right] = false;
+  compiled_ = false;
+}
+
+void CRFTagger::TransitionTable::Compile() {
+  if (compiled_) return;
+
+  allowed_num_ = 0;
+  for (int right = 0; right < ysize_; ++right) {
+    int *predecessors = predecessors_ + ysize_ * right;
+    predecessor_num_[right] = 0;
+    for (int left = 0; left < ysize_; ++left) {
+      if (transition(left, right)) {
+        predecessors[predecessor_num_[right]++] = left;
+        allowed_num_++;
+      }
+    }
+  }
+
+  compiled_ = true;
 }
 
 void CRFTagger::TransitionTable::AllowAll() {
@@ -373,35 +806,61 @@ void CRFTagger::TransitionTable::DisallowAll() {
   }
 }
 
-CRFTagger::Lattice::Lattice(const CRFModel *model) {
+CRFTagger::Lattice::Lattice(const CRFModel *model): lattice_(NULL),
+                                                     top_(NULL),
+                                                     capacity_(0) {
   ysize_ = model->ysize();
-  for (int idx = 0; idx < kSequenceMax; ++idx) {
-    lattice_[idx] = new int[ysize_];
-    top_[idx] = 0;
-  }
 }
 
 CRFTagger::Lattice::~Lattice() {
-  for (int idx = 0; idx < kSequenceMax; ++idx) {
-    delete[] lattice_[idx];
-    lattice_[idx] = NULL;
+  Trim();
+}
+
+void CRFTagger::Lattice::Reserve(int size) {
+  if (size <= capacity_) return;
+
+  int capacity = std::max(size, capacity_ * 2);
+  int *lattice = new int[capacity * ysize_];
+  int *top = new int[capacity];
+  if (capacity_ > 0) {
+    memcpy(lattice, lattice_, sizeof(int) * capacity_ * ysize_);
+    memcpy(top, top_, sizeof(int) * capacity_);
   }
+  delete[] lattice_;
+  delete[] top_;
+  lattice_ = lattice;
+  top_ = top;
+
+  int old_capacity = capacity_;
+  capacity_ = capacity;
+  for (int idx = old_capacity; idx < capacity_; ++idx) AllowAll(idx);
+}
+
+void CRFTagger::Lattice::Trim() {
+  delete[] lattice_;
+  lattice_ = NULL;
+  delete[] top_;
+  top_ = NULL;
+  capacity_ = 0;
 }
 
 void CRFTagger::Lattice::Add(int idx, int y) {
-  assert(idx < kSequenceMax && top_[idx] < ysize_);
+  Reserve(idx + 1);
+  assert(top_[idx] < ysize_);
   int top = top_[idx];
-  lattice_[idx][top] = y;
+  lattice_[idx * ysize_ + top] = y;
   top_[idx]++;
 }
 
 void CRFTagger::Lattice::Clear(int idx) {
+  Reserve(idx + 1);
   top_[idx] = 0;
 }
 
 void CRFTagger::Lattice::AllowAll(int idx) {
+  Reserve(idx + 1);
   for (int i = 0; i < ysize_; ++i) {
-    lattice_[idx][i] = i;
+    lattice_[idx * ysize_ + i] = i;
   }
   top_[idx] = ysize_;
 }
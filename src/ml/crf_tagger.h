@@ -34,10 +34,13 @@
 #ifndef SRC_PARSER_CRF_TAGGER_H_
 #define SRC_PARSER_CRF_TAGGER_H_
 
-#include <string>
+#include <assert.h>
+#include <math.h>
+#include <vector>
 #include "common/milkcat_config.h"
 #include "ml/crf_model.h"
 #include "ml/sequence_feature_set.h"
+#include "ml/viterbi_kernel.h"
 
 namespace milkcat {
 
@@ -47,10 +50,17 @@ class CRFTagger {
  public:
   class TransitionTable;
   class Lattice;
+  class FeatureExtractor;
 
   explicit CRFTagger(const CRFModel *model);
   ~CRFTagger();
   static const int kMaxFeature = 24;
+  static const int kFeatureStringMax = 1024;
+  static const int kUnigramCacheSize = 4096;
+
+  // Window size and the overlap between windows of TagRangeWindowed
+  static const int kWindowSize = 512;
+  static const int kWindowOverlap = 32;
 
   // Tag a range of instance with the begin tag before the result and the end
   // tag after the result
@@ -60,6 +70,33 @@ class CRFTagger {
                 int begin_tag,
                 int end_tag);
 
+  // Tag the range [begin, end) of a sequence of `size` which may be much
+  // longer than `kWindowSize`. Only a window of the sequence is extracted by
+  // `extractor` and decoded at a time, the next window starts from the last
+  // position committed by previous one (pinned to its tag) and overlaps
+  // `kWindowOverlap` positions with it. So the memory is bounded and the
+  // result differs from TagRange only near the seams. Results are retrived
+  // by y(0 .. end - begin - 1)
+  void TagRangeWindowed(FeatureExtractor *extractor,
+                        int size,
+                        int begin,
+                        int end,
+                        int begin_tag,
+                        int end_tag);
+
+  // Uses a decoder specialized on a fixed tagset at compile time in
+  // TagRange. `Tagset` defines kTagNum and the allowed transitions
+  // kTransition[kTagNum][kTagNum] in its own tag order, `tag_ids` maps them
+  // to the tag ids in model. All tags in model should be in `Tagset`. The
+  // whole Viterbi state of a position stays in local arrays,
+  // `transition_table_` is not used by this decoder.
+  template<class Tagset>
+  void UseFixedDecoder(const int *tag_ids) {
+    assert(Tagset::kTagNum == model_->ysize());
+    fixed_tag_ids_.assign(tag_ids, tag_ids + Tagset::kTagNum);
+    fixed_decoder_ = &CRFTagger::FixedViterbi<Tagset>;
+  }
+
   // Tag a range of instance
   void TagRange(SequenceFeatureSet *sequence_feature_set, int begin, int end) {
     TagRange(sequence_feature_set, begin, end, -1, -1);
@@ -75,6 +112,12 @@ class CRFTagger {
     return result_[idx];
   }
 
+  // Gets the posterior probability of the result tag at `idx`, only
+  // available when compute_marginals() is true
+  double marginal(int idx) const {
+    return marginal_[idx];
+  }
+
   // Gets the number of tags in model
   int ysize() const {
     return model_->ysize();
@@ -92,25 +135,133 @@ class CRFTagger {
 
   const CRFModel *model() const { return model_; } 
 
+  // Enables the unigram feature cache. The xids of unigram templates which
+  // have only one %x[row,col] are cached by the id of the FeatureSet it
+  // refers (SequenceFeatureSet::id_at), so the FeatureSets with the same id
+  // only expand these templates once
+  void EnableUnigramCache();
+
+  // Sets the max-plus kernel (ViterbiKernel) used in Viterbi, it falls back
+  // to kAutoViterbiKernel when `kernel` is not supported by current CPU
+  void set_viterbi_kernel(int kernel);
+  int viterbi_kernel() const { return viterbi_kernel_; }
+
+  // Sets the beam size of Viterbi. When `beam_size` > 0 only the best
+  // `beam_size` states of each position (after its unigram cost) are kept
+  // as the left states of next position, it trades some accuracy for speed
+  // when the model has many tags. 0 keeps all states (exact Viterbi). The
+  // fixed-tagset decoder is never pruned
+  void set_beam_size(int beam_size) { beam_size_ = beam_size; }
+  int beam_size() const { return beam_size_; }
+
+  // Runs a forward-backward pass after decoding to get the posterior
+  // probabilities of the result tags (in the same lattice and transitions
+  // as Viterbi). It costs 1-2 times as much as the Viterbi itself, so it
+  // is disabled by default. In TagRangeWindowed the probabilities are
+  // computed in each window
+  void set_compute_marginals(bool compute_marginals) {
+    compute_marginals_ = compute_marginals;
+  }
+  bool compute_marginals() const { return compute_marginals_; }
+
+  // Releases the decoding buffers, they are sized by the longest sentence
+  // tagged and grow again on demand. The states in `lattice_` are reset to
+  // AllowAll
+  void Trim();
+
   // Gets `transition_table_` or `lattice_`
   TransitionTable *transition_table() { return transition_table_; }
   Lattice *lattice() { return lattice_; }
 
  private:
   struct Node;
+  class CompareTagByCost;
 
   const CRFModel *model_;
-  Node *decode_lattice_[kSequenceMax];
-  int result_[kSequenceMax];
+
+  // `decode_lattice_` is a [position][yid] table of `capacity_` positions in
+  // one allocation, it grows geometrically
+  Node *decode_lattice_;
+  int capacity_;
+  std::vector<int> result_;
+
+  // `marginal_` is the posterior probability of each result tag. `alpha_`,
+  // `beta_` and `unigram_weight_` are [position][yid] tables of the
+  // forward-backward pass. `bigram_weight_` are the exp(`bigram_matrix_`)
+  // in the pass, `weight_offset_` is the one of each position
+  bool compute_marginals_;
+  std::vector<double> marginal_;
+  std::vector<double> alpha_;
+  std::vector<double> beta_;
+  std::vector<double> unigram_weight_;
+  std::vector<double> bigram_weight_;
+  std::vector<int> weight_offset_;
   SequenceFeatureSet *sequence_feature_set_;
+
+  // Features of current window in TagRangeWindowed
+  SequenceFeatureSet *window_feature_set_;
   TransitionTable *transition_table_;
   Lattice *lattice_;
 
+  // The unigram feature cache, a direct-mapped table of `kUnigramCacheSize`
+  // slots, each slot is {id, xid of cacheable template 0, 1, ...}.
+  // `cache_column_[i]` is the index of unigram template i in slot or -1 if
+  // the template is not cacheable
+  int *unigram_cache_;
+  std::vector<int> cache_column_;
+  std::vector<int> cacheable_templates_;
+
+  // The bigram costs of all features at current position summed into a
+  // [left][right] matrix, disallowed transitions are -inf. Rows are padded
+  // to `stride_`. `matrix_feature_ids_` are the features summed in matrix,
+  // it is reused when the features of next position are the same. With more
+  // than one bigram template the features are summed before the previous
+  // cost is added, so the costs may differ from adding them one by one in
+  // the last bits (see viterbi_kernel_test)
+  int viterbi_kernel_;
+  int stride_;
+  CostType *bigram_matrix_;
+  CostType *prev_cost_;
+  CostType *best_cost_;
+  int *best_left_;
+  std::vector<int> matrix_feature_ids_;
+  bool matrix_valid_;
+
+  // The states of last position kept by PruneStates in ascending order of
+  // tag id, only used when `beam_size_` > 0
+  int beam_size_;
+  int *beam_states_;
+  int beam_state_num_;
+
+  // The fixed-tagset decoder set by UseFixedDecoder, NULL if not used.
+  // `fixed_back_` is its back pointers, `kTagNum` bytes for each position
+  void (CRFTagger::*fixed_decoder_)(int begin,
+                                    int end,
+                                    int begin_tag,
+                                    int end_tag);
+  std::vector<int> fixed_tag_ids_;
+  std::vector<unsigned char> fixed_back_;
+
+  // The fixed-tagset Viterbi, decodes and stores the result
+  template<class Tagset>
+  void FixedViterbi(int begin, int end, int begin_tag, int end_tag);
+
+  // Makes sure `decode_lattice_` and `lattice_` have at least `size`
+  // positions
+  void Reserve(int size);
+
+  // Gets the Viterbi nodes at `position`
+  inline Node *bucket(int position);
+
   // Get the xid of unigram/bigram features at `idx`, returns the number of
   // features
   int BigramFeatureAt(int idx, int *feature_ids);
   int UnigramFeatureAt(int idx, int *feature_ids);
 
+  // Gets the xid of cacheable unigram template (`column` in slot) that refers
+  // the FeatureSet at `index`
+  int CachedUnigramXid(int index, int column);
+
   // CLear the decode bucket
   void ClearBucket(int position);
 
@@ -119,16 +270,55 @@ class CRFTagger {
   void CalcBigramCost(int idx);
   void CalcBeginTagBigramCost(int begin, int begin_tag);
 
+  // Keeps the best `beam_size_` states at `idx` into `beam_states_`
+  void PruneStates(int idx);
+
+  // Sums the bigram costs of `feature_ids` into `bigram_matrix_`
+  void BuildBigramMatrix(const int *feature_ids, int feature_num);
+
+  // Updates `bigram_matrix_` to the bigram features at `idx`, returns true
+  // if the matrix is rebuilt
+  bool UpdateBigramMatrix(int idx);
+
   // Viterbi algorithm
   void Viterbi(int begin, int end, int begin_tag, int end_tag);
 
   // Get the best tag sequence from lattice and stores it into `lattice_`
   void StoreResult(int begin, int end, int end_tag);
 
-  const char *GetIndex(const char **pp, int position);
-  bool ApplyRule(std::string *output_str,
-                 const char *template_str,
-                 size_t position);
+  // Forward-backward algorithm, computes the posterior probabilities of
+  // `result_` into `marginal_`. It works on the exp of costs with the
+  // scaling of each position, instead of log-sum-exp
+  void ForwardBackward(int begin, int end, int begin_tag, int end_tag);
+
+  // Updates `bigram_matrix_` to the bigram features at `idx`, and appends
+  // its exp to `bigram_weight_` if it is rebuilt. Returns the offset of the
+  // weights for `idx` in `bigram_weight_`
+  int UpdateBigramWeight(int idx);
+
+  // Gets the observation string at (`position`, `column`), returns BOS or
+  // EOS string when `position` is out of the sequence
+  const char *Observation(int position, int column);
+
+  // Builds the feature string of `feature_template` at `position` into
+  // `buffer`, the size of `buffer` should be `kFeatureStringMax`
+  void BuildFeature(const CRFModel::FeatureTemplate &feature_template,
+                    int position,
+                    char *buffer);
+};
+
+// FeatureExtractor prepares a part of sequence for TagRangeWindowed
+class CRFTagger::FeatureExtractor {
+ public:
+  virtual ~FeatureExtractor() {}
+
+  // Puts the features of positions [begin, end) of the sequence into
+  // `sequence_feature_set` (with `begin` at index 0) and their states into
+  // `lattice`
+  virtual void Extract(SequenceFeatureSet *sequence_feature_set,
+                       Lattice *lattice,
+                       int begin,
+                       int end) = 0;
 };
 
 // TransitionTable stores the allowed transitions
@@ -150,8 +340,27 @@ class CRFTagger::TransitionTable {
     return transition_[ysize_ * left + right];
   }
 
+  // Compiles the allowed transitions into predecessor lists of each right
+  // tag if the table is changed. CRFTagger calls it before decoding
+  void Compile();
+
+  // Returns true if less than half of the transitions are allowed, Viterbi
+  // iterates the predecessor lists instead of the whole matrix in this case
+  bool sparse() const { return allowed_num_ * 2 < ysize_ * ysize_; }
+
+  // Gets the allowed left tags of `right` in ascending order, valid after
+  // Compile()
+  int predecessor_num(int right) const { return predecessor_num_[right]; }
+  const int *predecessors(int right) const {
+    return predecessors_ + ysize_ * right;
+  }
+
  private:
   bool *transition_;
+  int *predecessors_;
+  int *predecessor_num_;
+  int allowed_num_;
+  bool compiled_;
   int ysize_;
   const CRFModel *model_;
 };
@@ -162,6 +371,13 @@ class CRFTagger::Lattice {
   Lattice(const CRFModel *model);
   ~Lattice();
 
+  // Makes sure the lattice has at least `size` positions, new positions
+  // allows all states
+  void Reserve(int size);
+
+  // Releases all positions
+  void Trim();
+
   // Adds an state to the `idx` of table
   void Add(int idx, int y);
 
@@ -175,14 +391,129 @@ class CRFTagger::Lattice {
   int y_num(int idx) const { return top_[idx]; }
 
   // Gets the states at
-  int at(int idx, int num) const { return lattice_[idx][num]; }
+  int at(int idx, int num) const { return lattice_[idx * ysize_ + num]; }
 
  private:
-  int *lattice_[kSequenceMax];
-  int top_[kSequenceMax];
+  // `lattice_` is a [idx][num] table of `capacity_` positions
+  int *lattice_;
+  int *top_;
+  int capacity_;
   int ysize_;
 };
 
+template<class Tagset>
+void CRFTagger::FixedViterbi(int begin, int end, int begin_tag, int end_tag) {
+  enum { N = Tagset::kTagNum };
+  assert(model_->ysize() == N);
+
+  // `rank` is the model tag id of each tag in `Tagset`, `tag` is the
+  // reverse map
+  int rank[N], tag[N];
+  for (int i = 0; i < N; ++i) {
+    rank[i] = fixed_tag_ids_[i];
+    tag[fixed_tag_ids_[i]] = i;
+  }
+
+  // Allowed left tags of each right tag in the order of model tag id
+  int predecessors[N][N], predecessor_num[N];
+  for (int right = 0; right < N; ++right) {
+    predecessor_num[right] = 0;
+    for (int yid = 0; yid < N; ++yid) {
+      if (Tagset::kTransition[tag[yid]][right])
+        predecessors[right][predecessor_num[right]++] = tag[yid];
+    }
+  }
+
+  int feature_ids[kMaxFeature];
+  CostType cost[N], next_cost[N], matrix[N][N];
+  bool allowed[N];
+  result_.resize(end - begin);
+  fixed_back_.resize((end - begin + 1) * N);
+  unsigned char *back = &fixed_back_[0];
+
+  // The begin position, transition from `begin_tag` is always allowed
+  for (int y = 0; y < N; ++y) cost[y] = 0.0;
+  if (begin_tag >= 0) {
+    int feature_num = BigramFeatureAt(begin, feature_ids);
+    for (int y = 0; y < N; ++y) {
+      for (int i = 0; i < feature_num; ++i) {
+        cost[y] += model_->bigram_cost(feature_ids[i], begin_tag, rank[y]);
+      }
+    }
+  }
+
+  for (int position = begin; ; ++position) {
+    if (position == end && end_tag < 0) break;
+
+    if (position > begin) {
+      if (UpdateBigramMatrix(position)) {
+        for (int left = 0; left < N; ++left) {
+          for (int right = 0; right < N; ++right) {
+            matrix[left][right] = bigram_matrix_[rank[left] * stride_ +
+                                                 rank[right]];
+          }
+        }
+      }
+
+      // States not allowed at `position - 1` are -inf
+      for (int y = 0; y < N; ++y) {
+        if (allowed[y] == false) cost[y] = -HUGE_VAL;
+      }
+
+      unsigned char *position_back = back + (position - begin) * N;
+      for (int right = 0; right < N; ++right) {
+        CostType best_cost = -1e37;
+        int best_left = tag[0];
+        for (int i = 0; i < predecessor_num[right]; ++i) {
+          int left = predecessors[right][i];
+          CostType c = cost[left] + matrix[left][right];
+          if (c > best_cost) {
+            best_cost = c;
+            best_left = left;
+          }
+        }
+        next_cost[right] = best_cost;
+        position_back[right] = static_cast<unsigned char>(best_left);
+      }
+      for (int y = 0; y < N; ++y) cost[y] = next_cost[y];
+    }
+    if (position == end) break;
+
+    for (int y = 0; y < N; ++y) allowed[y] = false;
+    for (int i = 0; i < lattice_->y_num(position); ++i) {
+      allowed[tag[lattice_->at(position, i)]] = true;
+    }
+
+    int feature_num = UnigramFeatureAt(position, feature_ids);
+    for (int i = 0; i < feature_num; ++i) {
+      for (int y = 0; y < N; ++y) {
+        cost[y] += model_->unigram_cost(feature_ids[i], rank[y]);
+      }
+    }
+  }
+
+  int y;
+  if (end_tag >= 0) {
+    // Now `cost` is at `end`, back track from `end_tag`
+    y = back[(end - begin) * N + tag[end_tag]];
+  } else {
+    // Finds the best state at `end - 1`
+    CostType best_cost = -1e37;
+    y = tag[0];
+    for (int i = 0; i < lattice_->y_num(end - 1); ++i) {
+      int state = tag[lattice_->at(end - 1, i)];
+      if (best_cost < cost[state]) {
+        best_cost = cost[state];
+        y = state;
+      }
+    }
+  }
+  for (int position = end - 1; position >= begin; --position) {
+    result_[position - begin] = rank[y];
+    y = back[(position - begin) * N + y];
+  }
+}
+
 }  // namespace milkcat
 
 #endif  // SRC_PARSER_CRF_TAGGER_H_
@@ -161,6 +161,39 @@ const HMMModel::EmissionArray *HMMModel::Emission(const char *word) const {
   }
 }
 
+void HMMModel::BuildTermIdIndex(const ReimuTrie *term_index) {
+  std::string word;
+  ReimuTrie::int32 xid;
+  int position = 0;
+
+  term_xid_.clear();
+  while (index_->NextPair(&position, &word, &xid)) {
+    int term_id = term_index->Get(word.c_str(), -1);
+    if (term_id < 0 || term_id >= kUserTermIdStart) continue;
+
+    if (term_id >= static_cast<int>(term_xid_.size())) {
+      term_xid_.resize(term_id + 1, -1);
+    }
+    term_xid_[term_id] = xid;
+  }
+}
+
+const HMMModel::EmissionArray *HMMModel::Emission(const char *word,
+                                                  int term_id) const {
+  if (term_xid_.empty() || term_id < 0 || term_id >= kUserTermIdStart) {
+    return Emission(word);
+  }
+
+  // The words after the end of `term_xid_` have no emission
+  int xid = -1;
+  if (term_id < static_cast<int>(term_xid_.size())) xid = term_xid_[term_id];
+  if (xid >= 0) {
+    return emission_[xid];
+  } else {
+    return NULL;
+  }
+}
+
 HMMModel::HMMModel(const std::vector<std::string> &yname): 
     xsize_(0),
     yname_(yname) {
@@ -68,6 +68,16 @@ class HMMModel {
   // Gets EmissionArray by word. If the word does not exists, return NULL
   const EmissionArray *Emission(const char *word) const;
 
+  // Builds the table from the term_id in `term_index` to the emission of the
+  // same word. Then Emission(word, term_id) finds the emissions of words in
+  // `term_index` by array indexing instead of the trie lookup
+  void BuildTermIdIndex(const ReimuTrie *term_index);
+
+  // Gets EmissionArray by word and its term_id in the index of
+  // BuildTermIdIndex(). For the term_ids not in that index (user words and
+  // out-of-vocabulary words), looks up `word` instead
+  const EmissionArray *Emission(const char *word, int term_id) const;
+
   // Gets/Sets the transition cost from left_tag to right_tag
   float cost(int left_tag, int right_tag) const {
     return transition_cost_[left_tag * yname_.size() + right_tag];
@@ -79,6 +89,7 @@ class HMMModel {
  private:
   ReimuTrie *index_;
   std::vector<const EmissionArray *> emission_;
+  std::vector<int> term_xid_;
   float *transition_cost_;
   int xsize_;
   std::vector<std::string> yname_;
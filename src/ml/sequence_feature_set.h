@@ -28,34 +28,51 @@
 #define SRC_ML_SEQUENCE_FEATURE_SET_H_
 
 #include <assert.h>
+#include <vector>
 #include "common/milkcat_config.h"
 #include "ml/feature_set.h"
+#include "util/util.h"
 
 namespace milkcat {
 
-// A sequence of FeatureSet
+// A sequence of FeatureSet, it grows with set_size()
 class SequenceFeatureSet {
  public:
   SequenceFeatureSet(): size_(0) {
   }
 
+  ~SequenceFeatureSet() {
+    for (size_t i = 0; i < sequence_.size(); ++i) delete sequence_[i];
+  }
+
   // Returns the FeatureSet at `index`
   FeatureSet *at_index(int index) {
     assert(index < size_);
-    return &sequence_[index];
+    return sequence_[index];
   }
 
   // Sets/Gets the size of current SequenceFeatureSet
   void set_size(int size) {
-    assert(size_ < kTokenMax);
+    while (static_cast<int>(sequence_.size()) < size) {
+      sequence_.push_back(new FeatureSet());
+      id_.push_back(-1);
+    }
     size_ = size;
   }
   int size() const { return size_; }
 
+  // Sets/Gets the id of FeatureSet at `index`. FeatureSets with the same id
+  // (>= 0) should always have the same features, -1 means no id. CRFTagger
+  // uses it as the key of its unigram feature cache
+  void set_id_at(int index, int id) { id_[index] = id; }
+  int id_at(int index) const { return id_[index]; }
 
  private:
-  FeatureSet sequence_[kTokenMax];
+  std::vector<FeatureSet *> sequence_;
+  std::vector<int> id_;
   int size_;
+
+  DISALLOW_COPY_AND_ASSIGN(SequenceFeatureSet);
 };
 
 }  // namespace milkcat
@@ -0,0 +1,299 @@
+//
+// The MIT License (MIT)
+//
+// Copyright 2013-2014 The MilkCat Project Developers
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// viterbi_kernel.cc --- Created at 2015-03-14
+//
+
+#include "ml/viterbi_kernel.h"
+
+#include <assert.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MILKCAT_X86_KERNEL
+#define MILKCAT_TARGET_SSE2 __attribute__((target("sse2")))
+#define MILKCAT_TARGET_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define MILKCAT_X86_KERNEL
+#define MILKCAT_TARGET_SSE2
+#define MILKCAT_TARGET_AVX2
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+namespace milkcat {
+
+namespace {
+
+const double kMinCost = -1e37;
+
+template<typename T>
+void MaxPlusScalar(const T *prev_cost,
+                   const T *matrix,
+                   int size,
+                   int stride,
+                   T *best_cost,
+                   int *best_left) {
+  for (int right = 0; right < stride; ++right) {
+    best_cost[right] = static_cast<T>(kMinCost);
+    best_left[right] = 0;
+  }
+
+  for (int left = 0; left < size; ++left) {
+    const T *row = matrix + left * stride;
+    for (int right = 0; right < stride; ++right) {
+      T cost = prev_cost[left] + row[right];
+      if (cost > best_cost[right]) {
+        best_cost[right] = cost;
+        best_left[right] = left;
+      }
+    }
+  }
+}
+
+#ifdef MILKCAT_X86_KERNEL
+
+MILKCAT_TARGET_SSE2
+void MaxPlusSSE2(const double *prev_cost,
+                 const double *matrix,
+                 int size,
+                 int stride,
+                 double *best_cost,
+                 int *best_left) {
+  double left_buffer[2];
+  for (int right = 0; right < stride; right += 2) {
+    __m128d best = _mm_set1_pd(kMinCost);
+    __m128d best_index = _mm_setzero_pd();
+    for (int left = 0; left < size; ++left) {
+      __m128d cost = _mm_add_pd(_mm_set1_pd(prev_cost[left]),
+                                _mm_loadu_pd(matrix + left * stride + right));
+      __m128d mask = _mm_cmpgt_pd(cost, best);
+      best = _mm_or_pd(_mm_and_pd(mask, cost), _mm_andnot_pd(mask, best));
+      best_index = _mm_or_pd(
+          _mm_and_pd(mask, _mm_set1_pd(static_cast<double>(left))),
+          _mm_andnot_pd(mask, best_index));
+    }
+    _mm_storeu_pd(best_cost + right, best);
+    _mm_storeu_pd(left_buffer, best_index);
+    best_left[right] = static_cast<int>(left_buffer[0]);
+    best_left[right + 1] = static_cast<int>(left_buffer[1]);
+  }
+}
+
+MILKCAT_TARGET_SSE2
+void MaxPlusSSE2(const float *prev_cost,
+                 const float *matrix,
+                 int size,
+                 int stride,
+                 float *best_cost,
+                 int *best_left) {
+  float left_buffer[4];
+  for (int right = 0; right < stride; right += 4) {
+    __m128 best = _mm_set1_ps(static_cast<float>(kMinCost));
+    __m128 best_index = _mm_setzero_ps();
+    for (int left = 0; left < size; ++left) {
+      __m128 cost = _mm_add_ps(_mm_set1_ps(prev_cost[left]),
+                               _mm_loadu_ps(matrix + left * stride + right));
+      __m128 mask = _mm_cmpgt_ps(cost, best);
+      best = _mm_or_ps(_mm_and_ps(mask, cost), _mm_andnot_ps(mask, best));
+      best_index = _mm_or_ps(
+          _mm_and_ps(mask, _mm_set1_ps(static_cast<float>(left))),
+          _mm_andnot_ps(mask, best_index));
+    }
+    _mm_storeu_ps(best_cost + right, best);
+    _mm_storeu_ps(left_buffer, best_index);
+    for (int i = 0; i < 4; ++i) {
+      best_left[right + i] = static_cast<int>(left_buffer[i]);
+    }
+  }
+}
+
+MILKCAT_TARGET_AVX2
+void MaxPlusAVX2(const double *prev_cost,
+                 const double *matrix,
+                 int size,
+                 int stride,
+                 double *best_cost,
+                 int *best_left) {
+  double left_buffer[4];
+  for (int right = 0; right < stride; right += 4) {
+    __m256d best = _mm256_set1_pd(kMinCost);
+    __m256d best_index = _mm256_setzero_pd();
+    for (int left = 0; left < size; ++left) {
+      __m256d cost = _mm256_add_pd(
+          _mm256_set1_pd(prev_cost[left]),
+          _mm256_loadu_pd(matrix + left * stride + right));
+      __m256d mask = _mm256_cmp_pd(cost, best, _CMP_GT_OQ);
+      best = _mm256_blendv_pd(best, cost, mask);
+      best_index = _mm256_blendv_pd(best_index,
+                                    _mm256_set1_pd(static_cast<double>(left)),
+                                    mask);
+    }
+    _mm256_storeu_pd(best_cost + right, best);
+    _mm256_storeu_pd(left_buffer, best_index);
+    for (int i = 0; i < 4; ++i) {
+      best_left[right + i] = static_cast<int>(left_buffer[i]);
+    }
+  }
+}
+
+MILKCAT_TARGET_AVX2
+void MaxPlusAVX2(const float *prev_cost,
+                 const float *matrix,
+                 int size,
+                 int stride,
+                 float *best_cost,
+                 int *best_left) {
+  float left_buffer[8];
+  for (int right = 0; right < stride; right += 8) {
+    __m256 best = _mm256_set1_ps(static_cast<float>(kMinCost));
+    __m256 best_index = _mm256_setzero_ps();
+    for (int left = 0; left < size; ++left) {
+      __m256 cost = _mm256_add_ps(
+          _mm256_set1_ps(prev_cost[left]),
+          _mm256_loadu_ps(matrix + left * stride + right));
+      __m256 mask = _mm256_cmp_ps(cost, best, _CMP_GT_OQ);
+      best = _mm256_blendv_ps(best, cost, mask);
+      best_index = _mm256_blendv_ps(best_index,
+                                    _mm256_set1_ps(static_cast<float>(left)),
+                                    mask);
+    }
+    _mm256_storeu_ps(best_cost + right, best);
+    _mm256_storeu_ps(left_buffer, best_index);
+    for (int i = 0; i < 8; ++i) {
+      best_left[right + i] = static_cast<int>(left_buffer[i]);
+    }
+  }
+}
+
+bool CPUSupportsAVX2() {
+#if defined(__GNUC__)
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2") != 0;
+#else
+  int info[4];
+  __cpuid(info, 0);
+  if (info[0] < 7) return false;
+
+  // Checks whether the OS saves the YMM registers
+  __cpuid(info, 1);
+  if ((info[2] & (1 << 27)) == 0) return false;
+  if ((_xgetbv(0) & 6) != 6) return false;
+
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+#endif
+}
+
+#endif  // MILKCAT_X86_KERNEL
+
+}  // namespace
+
+bool ViterbiKernelSupported(int kernel) {
+  switch (kernel) {
+    case kAutoViterbiKernel:
+    case kScalarViterbiKernel:
+      return true;
+#ifdef MILKCAT_X86_KERNEL
+    case kSSE2ViterbiKernel:
+      return true;
+    case kAVX2ViterbiKernel:
+      return CPUSupportsAVX2();
+#endif
+    default:
+      return false;
+  }
+}
+
+namespace {
+
+int DetectBestViterbiKernel() {
+  if (ViterbiKernelSupported(kAVX2ViterbiKernel)) {
+    return kAVX2ViterbiKernel;
+  } else if (ViterbiKernelSupported(kSSE2ViterbiKernel)) {
+    return kSSE2ViterbiKernel;
+  } else {
+    return kScalarViterbiKernel;
+  }
+}
+
+// Detected once at static initialization, before any thread could run
+// BestViterbiKernel()
+const int kBestViterbiKernel = DetectBestViterbiKernel();
+
+}  // namespace
+
+int BestViterbiKernel() {
+  return kBestViterbiKernel;
+}
+
+namespace {
+
+// Dispatches to the kernel for cost type `T`
+template<typename T>
+void RunMaxPlus(int kernel,
+                const T *prev_cost,
+                const T *matrix,
+                int size,
+                int stride,
+                T *best_cost,
+                int *best_left) {
+  assert(stride % kViterbiKernelAlign == 0 && size <= stride);
+  if (kernel == kAutoViterbiKernel) kernel = BestViterbiKernel();
+
+  switch (kernel) {
+#ifdef MILKCAT_X86_KERNEL
+    case kSSE2ViterbiKernel:
+      MaxPlusSSE2(prev_cost, matrix, size, stride, best_cost, best_left);
+      break;
+    case kAVX2ViterbiKernel:
+      MaxPlusAVX2(prev_cost, matrix, size, stride, best_cost, best_left);
+      break;
+#endif
+    default:
+      MaxPlusScalar(prev_cost, matrix, size, stride, best_cost, best_left);
+  }
+}
+
+}  // namespace
+
+void MaxPlus(int kernel,
+             const double *prev_cost,
+             const double *matrix,
+             int size,
+             int stride,
+             double *best_cost,
+             int *best_left) {
+  RunMaxPlus(kernel, prev_cost, matrix, size, stride, best_cost, best_left);
+}
+
+void MaxPlus(int kernel,
+             const float *prev_cost,
+             const float *matrix,
+             int size,
+             int stride,
+             float *best_cost,
+             int *best_left) {
+  RunMaxPlus(kernel, prev_cost, matrix, size, stride, best_cost, best_left);
+}
+
+}  // namespace milkcat
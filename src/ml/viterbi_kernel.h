@@ -0,0 +1,73 @@
+//
+// The MIT License (MIT)
+//
+// Copyright 2013-2014 The MilkCat Project Developers
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// viterbi_kernel.h --- Created at 2015-03-14
+//
+
+#ifndef SRC_ML_VITERBI_KERNEL_H_
+#define SRC_ML_VITERBI_KERNEL_H_
+
+namespace milkcat {
+
+// The max-plus kernels used by Viterbi decoding. For each `right` in
+// [0, stride), MaxPlus finds the `left` in [0, size) maximizing
+//   prev_cost[left] + matrix[left * stride + right]
+// and stores the maximum into best_cost[right], the `left` into
+// best_left[right]. If no cost is larger than -1e37, they would be -1e37 and
+// 0. The first `left` wins when tied, so all kernels give exactly the same
+// results. `stride` should be a multiple of kViterbiKernelAlign, the padding
+// of `matrix` should be -inf. Both double and float costs are supported, a
+// float vector holds twice as many costs
+enum ViterbiKernel {
+  kAutoViterbiKernel = 0,
+  kScalarViterbiKernel = 1,
+  kSSE2ViterbiKernel = 2,
+  kAVX2ViterbiKernel = 3
+};
+
+const int kViterbiKernelAlign = 8;
+
+// Returns true if `kernel` could run on current CPU
+bool ViterbiKernelSupported(int kernel);
+
+// Returns the fastest kernel that could run on current CPU
+int BestViterbiKernel();
+
+// Runs the max-plus `kernel`, `kernel` should be supported by current CPU
+void MaxPlus(int kernel,
+             const double *prev_cost,
+             const double *matrix,
+             int size,
+             int stride,
+             double *best_cost,
+             int *best_left);
+void MaxPlus(int kernel,
+             const float *prev_cost,
+             const float *matrix,
+             int size,
+             int stride,
+             float *best_cost,
+             int *best_left);
+
+}  // namespace milkcat
+
+#endif  // SRC_ML_VITERBI_KERNEL_H_
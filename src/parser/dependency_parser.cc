@@ -27,6 +27,7 @@
 #include "parser/dependency_parser.h"
 
 #include <stdio.h>
+#include <algorithm>
 #include <set>
 #include <string>
 #include "ml/feature_set.h"
@@ -52,6 +53,9 @@ DependencyParser::DependencyParser(PerceptronModel *perceptron_model,
   feature_set_ = new FeatureSet();
   perceptron_ = new Perceptron(perceptron_model);
   feature_ = feature;
+  chunk_term_instance_ = new TermInstance();
+  chunk_tag_instance_ = new PartOfSpeechTagInstance();
+  chunk_tree_instance_ = new TreeInstance();
 
   // Initialize the yid information from the prediction of perceptron
   yid_transition_.resize(perceptron_model->ysize());
@@ -137,6 +141,56 @@ DependencyParser::~DependencyParser() {
 
   delete node_pool_;
   node_pool_ = NULL;
+
+  delete chunk_term_instance_;
+  chunk_term_instance_ = NULL;
+
+  delete chunk_tag_instance_;
+  chunk_tag_instance_ = NULL;
+
+  delete chunk_tree_instance_;
+  chunk_tree_instance_ = NULL;
+}
+
+void DependencyParser::ParseSentence(
+    TreeInstance *tree_instance,
+    const TermInstance *term_instance,
+    const PartOfSpeechTagInstance *part_of_speech_tag_instance) {
+  int size = term_instance->size();
+  if (size <= kMaxSentenceLength) {
+    Parse(tree_instance, term_instance, part_of_speech_tag_instance);
+    return;
+  }
+
+  for (int begin = 0; begin < size; begin += kMaxSentenceLength) {
+    int end = std::min(begin + kMaxSentenceLength, size);
+    for (int i = begin; i < end; ++i) {
+      chunk_term_instance_->set_value_at(
+          i - begin,
+          term_instance->term_text_at(i),
+          term_instance->token_number_at(i),
+          term_instance->term_type_at(i),
+          term_instance->term_id_at(i));
+      chunk_tag_instance_->set_value_at(
+          i - begin,
+          part_of_speech_tag_instance->part_of_speech_tag_at(i),
+          part_of_speech_tag_instance->is_out_of_vocabulary_word_at(i));
+    }
+    chunk_term_instance_->set_size(end - begin);
+    chunk_tag_instance_->set_size(end - begin);
+
+    Parse(chunk_tree_instance_, chunk_term_instance_, chunk_tag_instance_);
+
+    // Head ids in the chunk are 1-based and 0 is the root
+    for (int i = begin; i < end; ++i) {
+      int head = chunk_tree_instance_->head_node_at(i - begin);
+      tree_instance->set_value_at(
+          i,
+          chunk_tree_instance_->dependency_type_at(i - begin),
+          head == 0? 0: head + begin);
+    }
+  }
+  tree_instance->set_size(size);
 }
 
 void DependencyParser::LoadDependencyTreeInstance(
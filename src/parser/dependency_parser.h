@@ -60,6 +60,15 @@ class DependencyParser {
     const TermInstance *term_instance,
     const PartOfSpeechTagInstance *part_of_speech_tag_instance) = 0;
 
+  // Parses a sentence of any length. Since the cost of each transition is
+  // proportional to the sentence length, sentences longer than
+  // `kMaxSentenceLength` terms are parsed as consecutive chunks, each chunk
+  // has its own root
+  void ParseSentence(
+    TreeInstance *tree_instance,
+    const TermInstance *term_instance,
+    const PartOfSpeechTagInstance *part_of_speech_tag_instance);
+
   // Load a dependency tree from training corpus, Stores it into term_instance,
   // tag_instance and tree_instance
   static void LoadDependencyTreeInstance(
@@ -82,6 +91,10 @@ class DependencyParser {
   int ysize();
 
  protected:
+  enum {
+    kMaxSentenceLength = 1023
+  };
+
   Perceptron *perceptron_;
   FeatureTemplate *feature_;
   FeatureSet *feature_set_;
@@ -99,6 +112,11 @@ class DependencyParser {
   const TermInstance *term_instance_;
   const PartOfSpeechTagInstance *part_of_speech_tag_instance_;
 
+  // Buffers for parsing a long sentence chunk by chunk
+  TermInstance *chunk_term_instance_;
+  PartOfSpeechTagInstance *chunk_tag_instance_;
+  TreeInstance *chunk_tree_instance_;
+
   // Returns true if `state` allows transition `yid`
   bool Allow(const State *state, int yid) const;
 
@@ -42,11 +42,11 @@ DependencyParser::State::State(): sentence_length_(0),
 
 void DependencyParser::State::Initialize(Pool<Node> *node_pool,
                                          int sentance_length) {
-  sentence_length_ = std::min(sentance_length + 1,
-                              static_cast<int>(kMaxInputSize));
+  sentence_length_ = sentance_length + 1;
+  sentence_.resize(sentence_length_);
 
   node_pool_ = node_pool;
-  for (int i = 0; i < sentance_length + 1; ++i) {
+  for (int i = 0; i < sentence_length_; ++i) {
     Node *node = node_pool->Alloc();
     node->Initialize(i);
     sentence_[i] = node;
@@ -179,6 +179,7 @@ void DependencyParser::State::CopyTo(State *target_state) const {
   target_state->previous_ = previous_;
   target_state->last_transition_ = last_transition_;
 
+  target_state->sentence_.resize(sentence_length_);
   for (int i = 0; i < sentence_length_; ++i) {
     Node *node = node_pool_->Alloc();
     sentence_[i]->CopyTo(node);
@@ -29,6 +29,7 @@
 #define SRC_PARSER_STATE_H_
 
 #include <vector>
+#include "common/milkcat_config.h"
 #include "parser/dependency_parser.h"
 #include "util/util.h"
 
@@ -39,11 +40,6 @@ template<class T> class Pool;
 // State in the dependency parser, including buffer, stack, tree ...
 class DependencyParser::State {
  public:
-  enum {
-    kMaxStackSize = 128,
-    kMaxInputSize = 1024
-  };
-
   State();
 
   // Initialize and allocate nodes for the sentence
@@ -85,8 +81,8 @@ class DependencyParser::State {
   // Copy current state to `target_state`
   void CopyTo(State *target_state) const;
 
-  double weight() const { return weight_; }
-  void set_weight(double weight) { weight_ = weight; }
+  CostType weight() const { return weight_; }
+  void set_weight(CostType weight) { weight_ = weight; }
 
   // The previous state that before a transition
   State *previous() const { return previous_; }
@@ -107,10 +103,10 @@ class DependencyParser::State {
   std::vector<int> stack_;
   std::vector<int> input_;
   
-  Node *sentence_[kMaxInputSize];
+  std::vector<Node *> sentence_;
   int sentence_length_;
 
-  double weight_;
+  CostType weight_;
   State *previous_;
   bool correct_;
   bool have_root_;
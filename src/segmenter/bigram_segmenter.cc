@@ -42,69 +42,42 @@
 
 namespace milkcat {
 
-struct BigramSegmenter::Node {
-  int beam_id;            // The bucket contains this node
-  int term_id;            // term_id for this node
-  double cost;            // Cost in this path  
-  const Node *from_node;  // Previous node pointer
-  int term_position;      // Position in a term_instance
-
-  inline void 
-  set_value(int beam_id, int term_id, double cost, const Node *from_node) {
-    this->beam_id = beam_id;
-    this->term_id = term_id;
-    this->cost = cost;
-    this->from_node = from_node;
-
-    if (from_node) {
-      this->term_position = from_node->term_position + 1;
-    } else {
-      this->term_position = -1;
-    }
-  }
-};
-
 struct BigramSegmenter::TraverseState {
   int index_from;
-  int userindex_from;
   bool index_end;
-  bool userindex_end;
 
-  TraverseState(): index_from(0),
-                   userindex_from(0),
-                   index_end(false), 
-                   userindex_end(false) {
-  }
+  TraverseState(): index_from(0), index_end(false) {}
 };
 
-// Compare two Node in cost
-class BigramSegmenter::NodeComparator {
+// Compares the states in k-best backtracing by the cost of their best full
+// path, which is the cost of its entry from viterbi decoding plus the cost of
+// its path to the end of sentence. The heap top is the least one
+class BigramSegmenter::NBestStateComparator {
  public:
-  bool operator()(BigramSegmenter::Node *n1, BigramSegmenter::Node *n2) {
-    return n1->cost < n2->cost;
+  explicit NBestStateComparator(const BigramSegmenter *segmenter):
+      segmenter_(segmenter) {
   }
+
+  bool operator()(int left, int right) const {
+    const NBestState &left_state = segmenter_->nbest_state_[left];
+    const NBestState &right_state = segmenter_->nbest_state_[right];
+    return segmenter_->cost_[left_state.entry] + left_state.cost >
+           segmenter_->cost_[right_state.entry] + right_state.cost;
+  }
+
+ private:
+  const BigramSegmenter *segmenter_;
 };
 
 BigramSegmenter::BigramSegmenter(): beam_size_(0),
-                                    node_pool_(NULL),
                                     unigram_cost_(NULL),
+                                    term_cost_(NULL),
                                     user_cost_(NULL),
                                     bigram_cost_(NULL),
-                                    index_(NULL),
-                                    user_index_(NULL),
-                                    has_user_index_(false) {
+                                    index_(NULL) {
 }
 
 BigramSegmenter::~BigramSegmenter() {
-  delete node_pool_;
-  node_pool_ = NULL;
-
-  for (int i = 0;
-       i < sizeof(lattice_) / sizeof(Beam<Node, NodeComparator> *);
-       ++i) {
-    delete lattice_[i];
-    lattice_[i] = NULL;
-  }
 }
 
 BigramSegmenter *BigramSegmenter::New(Model *model_factory,
@@ -113,23 +86,16 @@ BigramSegmenter *BigramSegmenter::New(Model *model_factory,
   BigramSegmenter *self = new BigramSegmenter();
 
   self->beam_size_ = use_bigram? kDefaultBeamSize: 1;
-  self->node_pool_ = new Pool<Node>();
-
-  // Initialize the lattice_
-  for (int i = 0;
-       i < sizeof(self->lattice_) / sizeof(Beam<Node, NodeComparator> *);
-       ++i) {
-    self->lattice_[i] = new Beam<Node, NodeComparator>(self->beam_size_);
-  }
 
-  self->index_ = model_factory->Index(status);
+  self->index_ = model_factory->OverlayIndex(status);
   if (status->ok() && model_factory->HasUserDictionary()) {
-    self->has_user_index_ = true;
-    self->user_index_ = model_factory->UserIndex(status);
-    if (status->ok()) self->user_cost_ = model_factory->UserCost(status);
+    self->user_cost_ = model_factory->UserCost(status);
   }
 
   if (status->ok()) self->unigram_cost_ = model_factory->UnigramCost(status);
+  if (status->ok()) {
+    self->term_cost_ = model_factory->OverlayUnigramCost(status);
+  }
   if (status->ok() && use_bigram == true) 
     self->bigram_cost_ = model_factory->BigramCost(status);
 
@@ -141,74 +107,54 @@ BigramSegmenter *BigramSegmenter::New(Model *model_factory,
   }
 }
 
-// Traverse the system and user index to find the term_id at current position,
-// then get the unigram cost for the term-id. Return the term-id and stores the
-// cost in double &unigram_cost
+// Traverse the index of system and user words to find the term_id at current
+// position, then get the unigram cost for the term-id. Return the term-id and
+// stores the cost in `*right_cost`
 // NOTE: If the word in current position exists both in system dictionary and
-// user dictionary, returns the term-id in system dictionary and stores the cost
-// of user dictionary into unigram_cost if its value is not kDefaultCost
+// user dictionary, the index has the term-id in system dictionary and
+// `term_cost_` has the cost of user dictionary if its value is not
+// kDefaultCost
 int BigramSegmenter::GetTermIdAndUnigramCost(
     const char *token_string,
     TraverseState *traverse_state,
-    double *right_cost) {
-
-  ReimuTrie::int32 term_id = -1, uterm_id = -1;
-
-  if (traverse_state->index_end == false) {
-    bool exist = index_->Traverse(
-        &traverse_state->index_from,
-        token_string,
-        &term_id,
-        -1);
-    if (exist == false) {
-      traverse_state->index_end = true;
-      term_id = -1;
-    }
-    if (term_id >= 0) {
-      *right_cost = unigram_cost_->get(term_id);
-      LOG("System unigram find: %d, cost = %f\n", term_id, *right_cost);
-    }
+    CostType *right_cost) {
+  ReimuTrie::int32 term_id = -1;
+
+  bool exist = index_->Traverse(
+      &traverse_state->index_from,
+      token_string,
+      &term_id,
+      -1);
+  if (exist == false) {
+    traverse_state->index_end = true;
+    term_id = -1;
   }
 
-  if (traverse_state->userindex_end == false) {
-    bool exist = user_index_->Traverse(
-        &traverse_state->userindex_from,
-        token_string,
-        &uterm_id,
-        -1);
-    if (exist == false) {
-      traverse_state->userindex_end = true;
-      uterm_id = -1;
-    }
-    if (uterm_id >= 0) {
-      double cost = user_cost_->get(uterm_id - kUserTermIdStart);
-      LOG("User unigram find: %d, cost = %f\n", uterm_id, cost);
-
-      if (term_id < 0) {
-        *right_cost = cost;
-
-        // Use term id in user dictionary iff term-id in system dictionary not
-        // exist
-        term_id = uterm_id;
-      } else if (cost != kDefaultCost) {
-        // The word exists in both system and user index. So when the cost in 
-        // user index is not `kDefaultCost`, use the cost in user index.
-        *right_cost = cost;
-      }
-    }
+  if (term_id >= 0) {
+    *right_cost = TermCost(term_id);
+    LOG("Unigram find: %d, cost = %f\n", term_id, *right_cost);
   }
 
   return term_id;
 }
 
+inline CostType BigramSegmenter::TermCost(int term_id) const {
+  if (term_id >= kUserTermIdStart) {
+    return user_cost_->get(term_id - kUserTermIdStart);
+  } else {
+    return term_cost_->get(term_id);
+  }
+}
+
 // Calculates the cost form left word-id to right term-id in bigram model. The
 // cost equals -log(p(right_word|left_word)). If no bigram data exists, use
 // unigram model cost = -log(p(right_word))
-inline double BigramSegmenter::CalculateBigramCost(int left_id,
-                                                   int right_id,
-                                                   double left_cost,
-                                                   double right_cost) {
-  double cost;
+inline CostType BigramSegmenter::CalculateBigramCost(
+    int left_id,
+    int right_id,
+    CostType left_cost,
+    CostType right_cost) {
+  CostType cost;
 
   // If bigram is disabled
   if (bigram_cost_ == NULL) return left_cost + right_cost;
@@ -229,15 +175,39 @@ inline double BigramSegmenter::CalculateBigramCost(int left_id,
   return cost;
 }
 
+inline void BigramSegmenter::AddToLattice(int position,
+                                          int term_id,
+                                          CostType cost,
+                                          int from_entry) {
+  int begin = position * beam_size_;
+  int idx = lattice_size_[position];
+  if (idx == beam_size_) {
+    // The beam is full, replaces its worst entry
+    if (cost >= cost_[begin + idx - 1]) return;
+    --idx;
+  } else {
+    ++lattice_size_[position];
+  }
+
+  // Keeps the entries sorted by cost, the earlier one comes first on ties
+  while (idx > 0 && cost_[begin + idx - 1] > cost) {
+    cost_[begin + idx] = cost_[begin + idx - 1];
+    term_id_[begin + idx] = term_id_[begin + idx - 1];
+    from_entry_[begin + idx] = from_entry_[begin + idx - 1];
+    --idx;
+  }
+  cost_[begin + idx] = cost;
+  term_id_[begin + idx] = term_id;
+  from_entry_[begin + idx] = from_entry;
+}
+
 void BigramSegmenter::AddPossibleTermToLattice(
     TokenInstance *token_instance, int position) {
   TraverseState traverse_state;
-  traverse_state.userindex_end = !has_user_index_;
-  double cost, right_cost;
-  const Node *node = NULL;
-  Node *new_node = NULL;
+  CostType cost, right_cost;
+  int begin = position * beam_size_;
+  int end = begin + lattice_size_[position];
 
-  lattice_[position]->Shrink();
   const char *token_str = NULL;
   int length_end = token_instance->size() - position;
   for (int length = 0; length < length_end; ++length) {
@@ -248,110 +218,191 @@ void BigramSegmenter::AddPossibleTermToLattice(
     int term_id = GetTermIdAndUnigramCost(token_str,
                                           &traverse_state,
                                           &right_cost);
-    double min_cost = 1e38;
-    const Node *min_node = NULL;
+    CostType min_cost = 1e38;
+    int min_entry = -1;
 
-    assert(lattice_[position]->size() > 0);
+    assert(end > begin);
 
     if (term_id >= 0) {
       // This token exists in unigram data
-      for (int node_id = 0;
-           node_id < lattice_[position]->size();
-           ++node_id) {
-        node = lattice_[position]->at(node_id);
-        double cost = CalculateBigramCost(node->term_id,
-                                          term_id,
-                                          node->cost,
-                                          right_cost);
+      for (int entry = begin; entry < end; ++entry) {
+        cost = CalculateBigramCost(term_id_[entry],
+                                   term_id,
+                                   cost_[entry],
+                                   right_cost);
         if (cost < min_cost) {
           min_cost = cost;
-          min_node = node;
+          min_entry = entry;
         }
       }
 
-      // Add the min_node to decode graph
-      new_node = node_pool_->Alloc();
-      new_node->set_value(position + length + 1, term_id, min_cost, min_node);
-      lattice_[position + length + 1]->Add(new_node);
+      // Add the min_entry to decode graph
+      AddToLattice(position + length + 1, term_id, min_cost, min_entry);
     } else {
       // One token out-of-vocabulary word should be always put into Decode
       // Graph When no arc to next bucket
-      if (length == 0 && lattice_[position + 1]->size() == 0) {
+      if (length == 0 && lattice_size_[position + 1] == 0) {
         LOG("Add OOV at %d\n", position);
-        for (int node_id = 0;
-             node_id < lattice_[position]->size();
-             ++node_id) {
-          node = lattice_[position]->at(node_id);
-          cost = node->cost + 20;
-
+        for (int entry = begin; entry < end; ++entry) {
+          cost = cost_[entry] + 20;
           if (cost < min_cost) {
             min_cost = cost;
-            min_node = node;
+            min_entry = entry;
           }
         }
 
-        new_node = node_pool_->Alloc();
-        new_node->set_value(position + length + 1, 0, min_cost, min_node);
-        lattice_[position + 1]->Add(new_node);
+        AddToLattice(position + 1, 0, min_cost, min_entry);
       }  // end if node count == 0
     }  // end if term_id >= 0
 
-    if (traverse_state.index_end && traverse_state.userindex_end) break;
+    if (traverse_state.index_end) break;
   }  // end for length
 }
 
+void BigramSegmenter::StoreTerm(TermInstance *term_instance,
+                                int term_position,
+                                TokenInstance *token_instance,
+                                int entry) {
+  int beam_id = entry / beam_size_;
+  int from_beam_id = from_entry_[entry] / beam_size_;
+
+  int term_type = beam_id - from_beam_id > 1?
+      Parser::kChineseWord:
+      TokenTypeToTermType(token_instance->token_type_at(from_beam_id));
+
+  int oov_id = TermInstance::kTermIdOutOfVocabulary;
+  term_instance->set_value_at(
+      term_position,
+      token_instance,
+      from_beam_id,
+      beam_id - from_beam_id,
+      term_type,
+      term_id_[entry] == 0? oov_id: term_id_[entry]);
+}
+
 void BigramSegmenter::StoreResult(TermInstance *term_instance, 
                                   TokenInstance *token_instance) {
-  // Find the best result from decoding graph
-  const Node *node = lattice_[token_instance->size()]->Best();
-
-  term_instance->set_size(node->term_position + 1);
-  int beam_id, from_beam_id, term_type;
-  std::string buffer;
-  while (node->term_position >= 0) {
-    buffer.clear();
-    beam_id = node->beam_id;
-    from_beam_id = node->from_node->beam_id;
-
-    for (int i = from_beam_id; i < beam_id; ++i) {
-      buffer.append(token_instance->token_text_at(i));
-    }
+  // The best entry is the first one of last position
+  int last_entry = token_instance->size() * beam_size_;
 
-    term_type = beam_id - from_beam_id > 1?
-        Parser::kChineseWord:
-        TokenTypeToTermType(token_instance->token_type_at(from_beam_id));
-
-    int oov_id = TermInstance::kTermIdOutOfVocabulary;
-    term_instance->set_value_at(
-        node->term_position,
-        buffer.c_str(),
-        beam_id - from_beam_id,
-        term_type,
-        node->term_id == 0? oov_id: node->term_id);
-    node = node->from_node;
-  }  // end while
+  int term_number = 0;
+  for (int entry = last_entry; from_entry_[entry] >= 0;
+       entry = from_entry_[entry]) {
+    ++term_number;
+  }
+  term_instance->set_size(term_number);
+
+  int term_position = term_number - 1;
+  for (int entry = last_entry; from_entry_[entry] >= 0;
+       entry = from_entry_[entry]) {
+    StoreTerm(term_instance, term_position, token_instance, entry);
+    --term_position;
+  }  // end for entry
 }
 
 void BigramSegmenter::Segment(TermInstance *term_instance,
                               TokenInstance *token_instance) {
-  Node *new_node = node_pool_->Alloc();
-  new_node->set_value(0, 0, 0, NULL);
-  // Add begin-of-sentence node
-  lattice_[0]->Add(new_node);
+  // Allocates the lattice for this sentence
+  int position_number = token_instance->size() + 1;
+  if (static_cast<int>(cost_.size()) < position_number * beam_size_) {
+    cost_.resize(position_number * beam_size_);
+    term_id_.resize(position_number * beam_size_);
+    from_entry_.resize(position_number * beam_size_);
+  }
+  lattice_size_.assign(position_number, 0);
+
+  // Add begin-of-sentence entry
+  AddToLattice(0, 0, 0, -1);
 
   // Strat decoding
   for (int beam_id = 0; beam_id < token_instance->size(); ++beam_id) {
-    // Shrink current bucket to ensure node number < n_best
     AddPossibleTermToLattice(token_instance, beam_id);
   }  // end for decode_start
 
   StoreResult(term_instance, token_instance);
+}
 
-  // Clear decode_node
-  for (int i = 0; i < token_instance->size() + 1; ++i) {
-    lattice_[i]->Clear();
+int BigramSegmenter::NBest(int n,
+                           TokenInstance *token_instance,
+                           TermInstance **term_instances,
+                           double *costs) {
+  NBestStateComparator comparator(this);
+  nbest_state_.clear();
+  nbest_heap_.clear();
+
+  // Starts from the entries at the end of sentence
+  int last_position = token_instance->size();
+  int begin = last_position * beam_size_;
+  int end = begin + lattice_size_[last_position];
+  NBestState state;
+  for (int entry = begin; entry < end; ++entry) {
+    state.entry = entry;
+    state.next_state = -1;
+    state.cost = 0;
+    nbest_state_.push_back(state);
+    nbest_heap_.push_back(nbest_state_.size() - 1);
+    std::push_heap(nbest_heap_.begin(), nbest_heap_.end(), comparator);
   }
-  node_pool_->ReleaseAll();
+
+  // Since the cost of an entry is the cost of its best path from the begin of
+  // sentence, the states are popped in the order of their best full path. So
+  // the paths reaching the begin of sentence are the k-best ones
+  int count = 0;
+  while (count < n && !nbest_heap_.empty()) {
+    std::pop_heap(nbest_heap_.begin(), nbest_heap_.end(), comparator);
+    int state_id = nbest_heap_.back();
+    nbest_heap_.pop_back();
+    NBestState current = nbest_state_[state_id];
+
+    if (from_entry_[current.entry] < 0) {
+      // Reaches the begin of sentence, stores the path
+      TermInstance *term_instance = term_instances[count];
+      int term_number = 0;
+      for (int i = current.next_state; i >= 0;
+           i = nbest_state_[i].next_state) {
+        ++term_number;
+      }
+      term_instance->set_size(term_number);
+
+      int term_position = 0;
+      for (int i = current.next_state; i >= 0;
+           i = nbest_state_[i].next_state) {
+        StoreTerm(term_instance,
+                  term_position,
+                  token_instance,
+                  nbest_state_[i].entry);
+        ++term_position;
+      }
+      costs[count] = current.cost;
+      ++count;
+      continue;
+    }
+
+    // Expands the entries in the position where the term of current state
+    // starts, the arc costs are the same as AddPossibleTermToLattice()
+    int term_id = term_id_[current.entry];
+    CostType right_cost = term_id == 0? 0: TermCost(term_id);
+    int position = from_entry_[current.entry] / beam_size_;
+    begin = position * beam_size_;
+    end = begin + lattice_size_[position];
+    for (int entry = begin; entry < end; ++entry) {
+      state.entry = entry;
+      state.next_state = state_id;
+      if (term_id == 0) {
+        state.cost = current.cost + 20;
+      } else {
+        state.cost = current.cost + CalculateBigramCost(term_id_[entry],
+                                                        term_id,
+                                                        0,
+                                                        right_cost);
+      }
+      nbest_state_.push_back(state);
+      nbest_heap_.push_back(nbest_state_.size() - 1);
+      std::push_heap(nbest_heap_.begin(), nbest_heap_.end(), comparator);
+    }
+  }
+
+  return count;
 }
 
 }  // namespace milkcat
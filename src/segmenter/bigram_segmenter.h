@@ -30,12 +30,11 @@
 
 #include <stdint.h>
 #include <set>
+#include <vector>
 #include "common/milkcat_config.h"
 #include "common/static_array.h"
 #include "common/static_hashtable.h"
-#include "ml/beam.h"
 #include "segmenter/segmenter.h"
-#include "util/pool.h"
 
 namespace milkcat {
 
@@ -51,9 +50,6 @@ class BigramSegmenter: public Segmenter {
   struct TraverseState;
 
  public:
-  // A node in decode graph
-  struct Node;
-
   // Create the bigram segmenter from a model factory. On success, return an
   // instance of BigramSegmenter. On failed, return NULL and set status
   // a failed value
@@ -66,45 +62,79 @@ class BigramSegmenter: public Segmenter {
   // Segment a token instance into term instance
   void Segment(TermInstance *term_instance, TokenInstance *token_instance);
 
- private:
-  class NodeComparator;
+  // Gets at most `n` best segmentations of the token instance from the lattice
+  // of last Segment(), so it should be called just after Segment() with the
+  // same `token_instance`. Stores the segmentations into `term_instances` and
+  // their costs into `costs` in ascending order of cost, returns the number
+  // of segmentations stored. Both arrays should have at least `n` elements.
+  // The segmentations are the best ones among the paths kept in the beams
+  int NBest(int n,
+            TokenInstance *token_instance,
+            TermInstance **term_instances,
+            double *costs);
 
+ private:
   static const int kDefaultBeamSize = 3;
-  // Number of Node in each buckets_
+  // Number of entries in each position of lattice
   int beam_size_;
 
-  // Buckets contain nodes for viterbi decoding
-  Beam<Node, NodeComparator> *lattice_[kTokenMax + 1];
-
-  // NodePool instance to alloc and release node
-  Pool<Node> *node_pool_;
-
-  // Costs for unigram and bigram.
+  // The lattice for viterbi decoding in flat arrays, it grows with the length
+  // of sentence. Position `p` has `lattice_size_[p]` entries from
+  // `p * beam_size_`, sorted by their cost. An entry is the term ends at `p`
+  // with its cost and the entry it comes from (-1 for the begin of sentence)
+  std::vector<CostType> cost_;
+  std::vector<int> term_id_;
+  std::vector<int> from_entry_;
+  std::vector<int> lattice_size_;
+
+  // The partial paths from the end of sentence in k-best backtracing. A state
+  // is the entry with the path to the end of sentence through `next_state`
+  struct NBestState {
+    int entry;
+    int next_state;
+    CostType cost;
+  };
+  class NBestStateComparator;
+  std::vector<NBestState> nbest_state_;
+  std::vector<int> nbest_heap_;
+
+  // Costs for unigram and bigram. `term_cost_` is the unigram cost of system
+  // words with the overrides of user dictionary
   const StaticArray<float> *unigram_cost_;
+  const StaticArray<float> *term_cost_;
   const StaticArray<float> *user_cost_;
   const StaticHashTable<int64_t, float> *bigram_cost_;
 
-  // Index for words in dictionary
+  // Index for words in system and user dictionary
   const ReimuTrie *index_;
-  const ReimuTrie *user_index_;
-  bool has_user_index_;
-
 
   BigramSegmenter();
 
-  double CalculateBigramCost(int left_id,
-                             int right_id,
-                             double left_cost,
-                             double right_cost);
+  // Gets the unigram cost of a term-id in system or user dictionary
+  CostType TermCost(int term_id) const;
+
+  CostType CalculateBigramCost(int left_id,
+                               int right_id,
+                               CostType left_cost,
+                               CostType right_cost);
 
   int GetTermIdAndUnigramCost(
       const char *token_string,
       TraverseState *traverse_state,
-      double *right_cost);
+      CostType *right_cost);
+
+  // Adds an entry to the lattice at `position` if it is in the beam
+  void AddToLattice(int position, int term_id, CostType cost, int from_entry);
 
   // Adds possible term to the lattice at `position`
   void AddPossibleTermToLattice(TokenInstance *token_instance, int position);
 
+  // Stores the term of lattice `entry` into `term_instance` at `term_position`
+  void StoreTerm(TermInstance *term_instance,
+                 int term_position,
+                 TokenInstance *token_instance,
+                 int entry);
+
   // Finds the best result from lattice and stores into term_instance 
   void StoreResult(TermInstance *term_instance,
                    TokenInstance *token_instance);
@@ -29,7 +29,9 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <algorithm>
 #include <string>
+#include <vector>
 #include "common/model.h"
 #include "ml/sequence_feature_set.h"
 #include "segmenter/term_instance.h"
@@ -38,13 +40,44 @@
 
 namespace milkcat {
 
+namespace {
+
+// Gets the unicode code point of 3-bytes UTF-8 character `text`
+inline int CodePoint(const char *text) {
+  const unsigned char *p = reinterpret_cast<const unsigned char *>(text);
+  return ((p[0] & 0x0f) << 12) | ((p[1] & 0x3f) << 6) | (p[2] & 0x3f);
+}
+
+// Returns true if the token at `idx` is a Chinese character
+inline bool IsChineseChar(const TokenInstance *token_instance, int idx) {
+  return token_instance->token_type_at(idx) == TokenInstance::kChineseChar;
+}
+
+// The tagset of segmenter in the order S, B, B1, B2, M, E
+struct SegmenterTagset {
+  enum { kTagNum = 6 };
+  static const bool kTransition[kTagNum][kTagNum];
+};
+
+const bool SegmenterTagset::kTransition[6][6] = {
+  // S      B      B1     B2     M      E
+  {true,  true,  false, false, false, false},  // S
+  {false, false, true,  false, false, true },  // B
+  {false, false, false, true,  false, true },  // B1
+  {false, false, false, false, true,  true },  // B2
+  {false, false, false, false, true,  true },  // M
+  {true,  true,  false, false, false, false}   // E
+};
+
+}  // namespace
+
 CRFSegmenter *CRFSegmenter::New(Model *model_factory, Status *status) {
   CRFSegmenter *self = new CRFSegmenter();
   const CRFModel *model = model_factory->CRFSegModel(status);
   
   if (status->ok()) {
     self->crf_tagger_ = new CRFTagger(model);
-    self->sequence_feature_set_ = new SequenceFeatureSet();
+    self->crf_tagger_->EnableUnigramCache();
 
     // Get the tag's value in CRF++ model
     self->S = self->crf_tagger_->yid("S");
@@ -65,20 +98,28 @@ CRFSegmenter *CRFSegmenter::New(Model *model_factory, Status *status) {
     CRFTagger::TransitionTable *
     transition_table = self->crf_tagger_->transition_table();
 
+    int *tag_ids = self->tag_ids_;
+    tag_ids[0] = self->S;
+    tag_ids[1] = self->B;
+    tag_ids[2] = self->B1;
+    tag_ids[3] = self->B2;
+    tag_ids[4] = self->M;
+    tag_ids[5] = self->E;
+
     // Speed up decoding by only calculating the specified transitions
     transition_table->DisallowAll();
-    transition_table->Allow(self->S, self->S);
-    transition_table->Allow(self->S, self->B);
-    transition_table->Allow(self->B, self->B1);
-    transition_table->Allow(self->B, self->E);
-    transition_table->Allow(self->B1, self->B2);
-    transition_table->Allow(self->B1, self->E);
-    transition_table->Allow(self->B2, self->M);
-    transition_table->Allow(self->B2, self->E);
-    transition_table->Allow(self->M, self->M);
-    transition_table->Allow(self->M, self->E);
-    transition_table->Allow(self->E, self->S);
-    transition_table->Allow(self->E, self->B);
+    for (int left = 0; left < SegmenterTagset::kTagNum; ++left) {
+      for (int right = 0; right < SegmenterTagset::kTagNum; ++right) {
+        if (SegmenterTagset::kTransition[left][right])
+          transition_table->Allow(tag_ids[left], tag_ids[right]);
+      }
+    }
+
+    // Uses the decoder specialized on segmenter tagset when the model has
+    // only these tags
+    if (self->crf_tagger_->ysize() == SegmenterTagset::kTagNum) {
+      self->crf_tagger_->UseFixedDecoder<SegmenterTagset>(tag_ids);
+    }
   }
 
   if (status->ok()) {
@@ -90,54 +131,100 @@ CRFSegmenter *CRFSegmenter::New(Model *model_factory, Status *status) {
 }
 
 CRFSegmenter::~CRFSegmenter() {
-  delete sequence_feature_set_;
-  sequence_feature_set_ = NULL;
-
   delete crf_tagger_;
   crf_tagger_ = NULL;
 }
 
 CRFSegmenter::CRFSegmenter(): crf_tagger_(NULL),
-                              sequence_feature_set_(NULL) {}
+                              token_instance_(NULL) {}
 
-void CRFSegmenter::SegmentRange(TermInstance *term_instance,
-                                TokenInstance *token_instance,
-                                int begin,
-                                int end) {
-  std::string buffer;
-
-  // Puts the `token_instance` into `sequence_feature_set_`
-  CRFTagger::Lattice *lattice = crf_tagger_->lattice();
-  sequence_feature_set_->set_size(token_instance->size());
-  for (int idx = 0; idx < token_instance->size(); ++idx) {
-    FeatureSet *feature_set = sequence_feature_set_->at_index(idx);
+void CRFSegmenter::Extract(SequenceFeatureSet *sequence_feature_set,
+                           CRFTagger::Lattice *lattice,
+                           int begin,
+                           int end) {
+  sequence_feature_set->set_size(end - begin);
+  for (int idx = begin; idx < end; ++idx) {
+    FeatureSet *feature_set = sequence_feature_set->at_index(idx - begin);
+    const char *token_text = token_instance_->token_text_at(idx);
 
     // Only one feature for word segmenter
     feature_set->Clear();
-    feature_set->Add(token_instance->token_text_at(idx));
+    feature_set->Add(token_text);
 
-    int token_type = token_instance->token_type_at(idx);
+    int token_type = token_instance_->token_type_at(idx);
     if (token_type == TokenInstance::kChineseChar) {
-      lattice->AllowAll(idx);
+      // Chinese characters are keyed by its code point in unigram cache
+      sequence_feature_set->set_id_at(idx - begin, CodePoint(token_text));
+      lattice->AllowAll(idx - begin);
     } else {
       // For other tokens just assign S tag
-      lattice->Clear(idx);
-      lattice->Add(idx, S);
+      sequence_feature_set->set_id_at(idx - begin, -1);
+      lattice->Clear(idx - begin);
+      lattice->Add(idx - begin, S);
     }
   }
+}
+
+void CRFSegmenter::SegmentRange(TermInstance *term_instance,
+                                TokenInstance *token_instance,
+                                int begin,
+                                int end) {
 
-  crf_tagger_->TagRange(sequence_feature_set_, begin, end, S, S);
+  // Non-Chinese tokens are always S, so the Viterbi path is independent on
+  // each side of them. Only the runs of Chinese characters between them are
+  // decoded, each run from the S token before it (to check the transition
+  // into the run) or from `begin`. A single character run is always a term
+  // itself, since only S and E are allowed before the end S
+  bool has_marginals = crf_tagger_->compute_marginals();
+  tags_.resize(end - begin);
+  marginals_.assign(end - begin, 1.0);
+  token_instance_ = token_instance;
+  int run_begin = begin;
+  while (run_begin < end) {
+    if (!IsChineseChar(token_instance, run_begin)) {
+      tags_[run_begin - begin] = S;
+      ++run_begin;
+      continue;
+    }
+
+    int run_end = run_begin + 1;
+    while (run_end < end && IsChineseChar(token_instance, run_end)) ++run_end;
+
+    if (run_end - run_begin == 1) {
+      tags_[run_begin - begin] = S;
+    } else {
+      // Only the tokens near the run are extracted into the tagger
+      int decode_begin = run_begin == begin? run_begin: run_begin - 1;
+      crf_tagger_->TagRangeWindowed(this,
+                                    token_instance->size(),
+                                    decode_begin,
+                                    run_end,
+                                    S,
+                                    S);
+      for (int i = run_begin; i < run_end; ++i) {
+        tags_[i - begin] = crf_tagger_->y(i - decode_begin);
+        if (has_marginals) {
+          marginals_[i - begin] = crf_tagger_->marginal(i - decode_begin);
+        }
+      }
+    }
+    run_begin = run_end;
+  }
+  token_instance_ = NULL;
 
   int tag_id;
   int term_count = 0;
   int i = 0;
   int token_count = 0;
   int term_type;
+  double confidence = 1.0;
   for (i = 0; i < end - begin; ++i) {
     token_count++;
-    buffer.append(token_instance->token_text_at(begin + i));
 
-    tag_id = crf_tagger_->y(i);
+    // The confidence of a term is the least posterior of its tokens
+    confidence = std::min(confidence, marginals_[i]);
+
+    tag_id = tags_[i];
     if (tag_id == S || tag_id == E) {
       if (tag_id == S) {
         term_type = TokenTypeToTermType(
@@ -147,20 +234,26 @@ void CRFSegmenter::SegmentRange(TermInstance *term_instance,
       }
 
       term_instance->set_value_at(term_count,
-                                  buffer.c_str(),
+                                  token_instance,
+                                  begin + i + 1 - token_count,
                                   token_count,
                                   term_type);
+      term_instance->set_confidence_at(term_count,
+                                       static_cast<float>(confidence));
       term_count++;
       token_count = 0;
-      buffer.clear();
+      confidence = 1.0;
     }
   }
 
-  if (!buffer.empty()) {
+  if (token_count > 0) {
     term_instance->set_value_at(term_count,
-                                buffer.c_str(),
+                                token_instance,
+                                end - token_count,
                                 token_count,
                                 Parser::kChineseWord);
+    term_instance->set_confidence_at(term_count,
+                                     static_cast<float>(confidence));
     term_count++;
   }
 
@@ -27,6 +27,7 @@
 #ifndef SRC_SEGMENTER_CRF_SEGMENTER_H_
 #define SRC_SEGMENTER_CRF_SEGMENTER_H_
 
+#include <vector>
 #include "ml/crf_tagger.h"
 #include "segmenter/segmenter.h"
 #include "tokenizer/token_instance.h"
@@ -38,7 +39,8 @@ class SequenceFeatureSet;
 class TermInstance;
 class Model;
 
-class CRFSegmenter: public Segmenter {
+class CRFSegmenter: public Segmenter,
+                    private CRFTagger::FeatureExtractor {
  public:
   static CRFSegmenter *New(Model *model_factory, Status *status);
   ~CRFSegmenter();
@@ -53,12 +55,33 @@ class CRFSegmenter: public Segmenter {
     SegmentRange(term_instance, token_instance, 0, token_instance->size());
   }
 
+  void Trim() { crf_tagger_->Trim(); }
+
+  CRFTagger *crf_tagger() const { return crf_tagger_; }
+
  private:
   CRFTagger *crf_tagger_;
-  SequenceFeatureSet *sequence_feature_set_;
+
+  // The tokens in segmenting, for Extract()
+  TokenInstance *token_instance_;
 
   int S, B, B1, B2, M, E;
 
+  // Tag ids of S, B, B1, B2, M, E in model
+  int tag_ids_[6];
+
+  // Tags of the range in SegmentRange and their posterior probabilities
+  // (when the marginals of `crf_tagger_` are computed)
+  std::vector<int> tags_;
+  std::vector<double> marginals_;
+
+  // Puts the tokens [begin, end) of `token_instance_` into the tagger, it
+  // implements CRFTagger::FeatureExtractor
+  void Extract(SequenceFeatureSet *sequence_feature_set,
+               CRFTagger::Lattice *lattice,
+               int begin,
+               int end);
+
   CRFSegmenter();
 
   DISALLOW_COPY_AND_ASSIGN(CRFSegmenter);
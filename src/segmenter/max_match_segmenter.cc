@@ -0,0 +1,173 @@
+//
+// The MIT License (MIT)
+//
+// Copyright 2013-2014 The MilkCat Project Developers
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// viterbi_kernel.h --- Created at 2015-03-14
+// max_match_segmenter.cc --- Created at 2015-03-20
+//
+
+#include "segmenter/max_match_segmenter.h"
+
+#include <string>
+#include <vector>
+#include "common/model.h"
+#include "common/reimu_trie.h"
+#include "include/milkcat.h"
+#include "segmenter/term_instance.h"
+#include "tokenizer/token_instance.h"
+#include "util/util.h"
+
+namespace milkcat {
+
+MaxMatchSegmenter::MaxMatchSegmenter(): index_(NULL), bidirectional_(false) {
+}
+
+MaxMatchSegmenter *MaxMatchSegmenter::New(Model *model_factory,
+                                          bool bidirectional,
+                                          Status *status) {
+  MaxMatchSegmenter *self = new MaxMatchSegmenter();
+  self->bidirectional_ = bidirectional;
+  self->index_ = model_factory->OverlayIndex(status);
+
+  if (status->ok()) {
+    return self;
+  } else {
+    delete self;
+    return NULL;
+  }
+}
+
+void MaxMatchSegmenter::MatchFrom(TokenInstance *token_instance, int begin) {
+  int from = 0;
+  ReimuTrie::int32 term_id;
+
+  forward_end_[begin] = -1;
+  for (int end = begin + 1; end <= token_instance->size(); ++end) {
+    bool exist = index_->Traverse(&from,
+                                  token_instance->token_text_at(end - 1),
+                                  &term_id,
+                                  -1);
+    if (exist == false) break;
+    if (term_id < 0) continue;
+
+    forward_end_[begin] = end;
+    forward_term_id_[begin] = term_id;
+
+    // Tokens are matched from left to right, so the first word ends at `end`
+    // is the longest one
+    if (backward_begin_[end] < 0) {
+      backward_begin_[end] = begin;
+      backward_term_id_[end] = term_id;
+    }
+  }
+}
+
+void MaxMatchSegmenter::StoreTerm(TermInstance *term_instance,
+                                  TokenInstance *token_instance,
+                                  int position,
+                                  int begin,
+                                  int end,
+                                  int term_id) {
+  int term_type = end - begin > 1?
+      Parser::kChineseWord:
+      TokenTypeToTermType(token_instance->token_type_at(begin));
+  term_instance->set_value_at(position,
+                              token_instance,
+                              begin,
+                              end - begin,
+                              term_type,
+                              term_id);
+}
+
+void MaxMatchSegmenter::Segment(TermInstance *term_instance,
+                                TokenInstance *token_instance) {
+  int size = token_instance->size();
+  int oov_id = TermInstance::kTermIdOutOfVocabulary;
+  forward_end_.resize(size);
+  forward_term_id_.resize(size);
+  backward_begin_.assign(size + 1, -1);
+  backward_term_id_.resize(size + 1);
+
+  // The forward matching only needs the words from the begin of terms, while
+  // the bidirectional matching needs the words from each token
+  bool use_backward = false;
+  if (bidirectional_) {
+    for (int begin = 0; begin < size; ++begin) {
+      MatchFrom(token_instance, begin);
+    }
+
+    int forward_terms = 0, forward_singles = 0;
+    for (int begin = 0; begin < size; ) {
+      int end = forward_end_[begin] > 0? forward_end_[begin]: begin + 1;
+      ++forward_terms;
+      if (end - begin == 1) ++forward_singles;
+      begin = end;
+    }
+
+    int backward_terms = 0, backward_singles = 0;
+    for (int end = size; end > 0; ) {
+      int begin = backward_begin_[end] >= 0? backward_begin_[end]: end - 1;
+      ++backward_terms;
+      if (end - begin == 1) ++backward_singles;
+      end = begin;
+    }
+
+    if (backward_terms != forward_terms) {
+      use_backward = backward_terms < forward_terms;
+    } else {
+      use_backward = backward_singles <= forward_singles;
+    }
+
+    if (use_backward) {
+      int position = backward_terms - 1;
+      for (int end = size; end > 0; ) {
+        int begin = end - 1, term_id = oov_id;
+        if (backward_begin_[end] >= 0) {
+          begin = backward_begin_[end];
+          term_id = backward_term_id_[end];
+        }
+        StoreTerm(term_instance, token_instance, position, begin, end, term_id);
+        --position;
+        end = begin;
+      }
+      term_instance->set_size(backward_terms);
+    }
+  }
+
+  if (use_backward == false) {
+    int position = 0;
+    for (int begin = 0; begin < size; ) {
+      if (bidirectional_ == false) MatchFrom(token_instance, begin);
+
+      int end = begin + 1, term_id = oov_id;
+      if (forward_end_[begin] > 0) {
+        end = forward_end_[begin];
+        term_id = forward_term_id_[begin];
+      }
+      StoreTerm(term_instance, token_instance, position, begin, end, term_id);
+      ++position;
+      begin = end;
+    }
+    term_instance->set_size(position);
+  }
+}
+
+}  // namespace milkcat
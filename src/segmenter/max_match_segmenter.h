@@ -0,0 +1,92 @@
+//
+// The MIT License (MIT)
+//
+// Copyright 2013-2014 The MilkCat Project Developers
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// viterbi_kernel.h --- Created at 2015-03-14
+// max_match_segmenter.h --- Created at 2015-03-20
+//
+
+#ifndef SRC_SEGMENTER_MAX_MATCH_SEGMENTER_H_
+#define SRC_SEGMENTER_MAX_MATCH_SEGMENTER_H_
+
+#include <vector>
+#include "segmenter/segmenter.h"
+#include "util/util.h"
+
+namespace milkcat {
+
+class ReimuTrie;
+class TokenInstance;
+class TermInstance;
+class Status;
+class Model;
+
+// MaxMatchSegmenter segments the tokens by maximum matching over the words
+// in system and user dictionary, without any cost. It is much faster than
+// BigramSegmenter with lower accuracy. The tokens not in any dictionary word
+// become single-token terms.
+class MaxMatchSegmenter: public Segmenter {
+ public:
+  // Creates the segmenter from a model factory. If `bidirectional` is true,
+  // it runs both forward and backward maximum matching and takes the one
+  // with fewer terms, then the one with fewer single-token terms, then the
+  // backward one. Otherwise it only runs the forward maximum matching. On
+  // failed, returns NULL and sets status a failed value
+  static MaxMatchSegmenter *New(Model *model_factory,
+                                bool bidirectional,
+                                Status *status);
+
+  // Segment a token instance into term instance
+  void Segment(TermInstance *term_instance, TokenInstance *token_instance);
+
+ private:
+  // Index for words in system and user dictionary
+  const ReimuTrie *index_;
+  bool bidirectional_;
+
+  // The longest word starts from each token: its end and term_id
+  std::vector<int> forward_end_;
+  std::vector<int> forward_term_id_;
+
+  // The longest word ends before each token: its begin and term_id
+  std::vector<int> backward_begin_;
+  std::vector<int> backward_term_id_;
+
+  MaxMatchSegmenter();
+
+  // Traverses the index from token `begin` and records the words found into
+  // `forward_end_` and `backward_begin_`
+  void MatchFrom(TokenInstance *token_instance, int begin);
+
+  // Stores the term of tokens [begin, end) at `position` of `term_instance`
+  void StoreTerm(TermInstance *term_instance,
+                 TokenInstance *token_instance,
+                 int position,
+                 int begin,
+                 int end,
+                 int term_id);
+
+  DISALLOW_COPY_AND_ASSIGN(MaxMatchSegmenter);
+};
+
+}  // namespace milkcat
+
+#endif  // SRC_SEGMENTER_MAX_MATCH_SEGMENTER_H_
@@ -26,6 +26,7 @@
 
 #include "segmenter/mixed_segmenter.h"
 #include "segmenter/bigram_segmenter.h"
+#include "segmenter/crf_segmenter.h"
 #include "segmenter/out_of_vocabulary_word_recognizer.h"
 #include "segmenter/term_instance.h"
 #include "tokenizer/token_instance.h"
@@ -35,7 +36,9 @@ namespace milkcat {
 MixedSegmenter::MixedSegmenter():
     bigram_result_(NULL),
     bigram_(NULL),
-    oov_recognizer_(NULL) {
+    oov_recognizer_(NULL),
+    oov_recognized_number_(0),
+    bigram_only_number_(0) {
 }
 
 MixedSegmenter *MixedSegmenter::New(Model *model_factory, 
@@ -72,7 +75,19 @@ MixedSegmenter::~MixedSegmenter() {
 void MixedSegmenter::Segment(TermInstance *term_instance,
                              TokenInstance *token_instance) {
   bigram_->Segment(bigram_result_, token_instance);
-  oov_recognizer_->Recognize(term_instance, bigram_result_, token_instance);
+  if (oov_recognizer_->Recognize(term_instance,
+                                 bigram_result_,
+                                 token_instance)) {
+    ++oov_recognized_number_;
+  } else {
+    // No words to recognize, the result of bigram segmenter is the final one
+    term_instance->Swap(bigram_result_);
+    ++bigram_only_number_;
+  }
+}
+
+void MixedSegmenter::Trim() {
+  oov_recognizer_->crf_segmenter()->Trim();
 }
 
 }  // namespace milkcat
@@ -27,6 +27,7 @@
 #ifndef SRC_SEGMENTER_MIXED_SEGMENTER_H_
 #define SRC_SEGMENTER_MIXED_SEGMENTER_H_
 
+#include <stdint.h>
 #include "segmenter/segmenter.h"
 
 namespace milkcat {
@@ -48,10 +49,25 @@ class MixedSegmenter: public Segmenter {
   // Segment a token instance into term instance
   void Segment(TermInstance *term_instance, TokenInstance *token_instance);
 
+  // Trims the CRF segmenter of out-of-vocabulary word recognition
+  void Trim();
+
+  OutOfVocabularyWordRecognizer *oov_recognizer() const {
+    return oov_recognizer_;
+  }
+  BigramSegmenter *bigram_segmenter() const { return bigram_; }
+
+  // Number of sentences segmented with or without the out-of-vocabulary word
+  // recognition by CRF segmenter
+  int64_t oov_recognized_number() const { return oov_recognized_number_; }
+  int64_t bigram_only_number() const { return bigram_only_number_; }
+
  private:
   TermInstance *bigram_result_;
   BigramSegmenter *bigram_;
   OutOfVocabularyWordRecognizer *oov_recognizer_;
+  int64_t oov_recognized_number_;
+  int64_t bigram_only_number_;
 
   MixedSegmenter();
 };
@@ -31,6 +31,7 @@
 #include <string.h>
 #include "common/model.h"
 #include "common/reimu_trie.h"
+#include "common/static_array.h"
 #include "include/milkcat.h"
 #include "segmenter/crf_segmenter.h"
 #include "segmenter/term_instance.h"
@@ -47,6 +48,16 @@ OutOfVocabularyWordRecognizer *OutOfVocabularyWordRecognizer::New(
 
   if (status->ok()) {
     self->term_instance_ = new TermInstance();
+    self->oov_property_by_term_id_ = model_factory->OOVPropertyByTermId(
+        status);
+  }
+
+  // The words without a system term_id are looked up by their text, in the
+  // unigram index when every word of the property trie is in it, else in the
+  // property trie
+  if (status->ok() && model_factory->HasMergedOOVProperty()) {
+    self->index_ = model_factory->Index(status);
+  } else if (status->ok()) {
     self->oov_property_ = model_factory->OOVProperty(status);
   }
 
@@ -68,13 +79,36 @@ OutOfVocabularyWordRecognizer::~OutOfVocabularyWordRecognizer() {
 
 OutOfVocabularyWordRecognizer::OutOfVocabularyWordRecognizer():
     term_instance_(NULL),
-    crf_segmenter_(NULL) {
+    crf_segmenter_(NULL),
+    oov_property_(NULL),
+    index_(NULL),
+    oov_property_by_term_id_(NULL) {
+}
+
+int OutOfVocabularyWordRecognizer::OOVPropertyAt(TermInstance *term_instance,
+                                                 int position) const {
+  // Words from the system dictionary have the term_id of Model::Index()
+  int term_id = term_instance->term_id_at(position);
+  if ((term_id < 0 || term_id >= kUserTermIdStart) && index_ != NULL) {
+    term_id = index_->Get(term_instance->term_text_at(position), -1);
+  }
+  if (term_id >= 0 && term_id < kUserTermIdStart) {
+    if (term_id < oov_property_by_term_id_->size()) {
+      return oov_property_by_term_id_->get(term_id);
+    } else {
+      return kOOVNoProperty;
+    }
+  } else if (oov_property_ != NULL) {
+    return oov_property_->Get(term_instance->term_text_at(position),
+                              kOOVNoProperty);
+  } else {
+    return kOOVNoProperty;
+  }
 }
 
 void OutOfVocabularyWordRecognizer::GetOOVProperties(
    TermInstance *term_instance) {
-  for (int i = 0; i < term_instance->size(); ++i) 
-    oov_properties_[i] = kNoRecognize;
+  oov_properties_.assign(term_instance->size(), kNoRecognize);
 
   for (int i = 0; i < term_instance->size(); ++i) {
     int token_number = term_instance->token_number_at(i);
@@ -84,9 +118,8 @@ void OutOfVocabularyWordRecognizer::GetOOVProperties(
     } else if (term_type != Parser::kChineseWord) {
       continue;
     } else {
-      const char *term_text = term_instance->term_text_at(i);
-      int oov_property = oov_property_->Get(term_text, -1);
-      if (oov_property < 0) {
+      int oov_property = OOVPropertyAt(term_instance, i);
+      if (oov_property == kOOVNoProperty) {
         oov_properties_[i] = kDoRecognize;
       } else {
         switch (oov_property) {
@@ -113,7 +146,7 @@ void OutOfVocabularyWordRecognizer::GetOOVProperties(
   }
 }
 
-void OutOfVocabularyWordRecognizer::Recognize(
+bool OutOfVocabularyWordRecognizer::Recognize(
     TermInstance *term_instance,
     TermInstance *in_term_instance,
     TokenInstance *in_token_instance) {
@@ -125,6 +158,18 @@ void OutOfVocabularyWordRecognizer::Recognize(
 
   GetOOVProperties(in_term_instance);
 
+  // The CRF segmenter only runs on the spans of at least two terms to
+  // recognize, skips the copying below if there is no such span
+  bool has_span = false;
+  for (int i = 1; i < in_term_instance->size(); ++i) {
+    if (oov_properties_[i - 1] == kDoRecognize &&
+        oov_properties_[i] == kDoRecognize) {
+      has_span = true;
+      break;
+    }
+  }
+  if (has_span == false) return false;
+
   for (int i = 0; i < in_term_instance->size(); ++i) {
     term_token_number = in_term_instance->token_number_at(i);
 
@@ -137,15 +182,15 @@ void OutOfVocabularyWordRecognizer::Recognize(
         RecognizeRange(in_token_instance, oov_begin_token, current_token);
 
         for (int j = 0; j < term_instance_->size(); ++j) {
-          CopyTermValue(term_instance, current_term, term_instance_, j);
+          term_instance->CopyFrom(current_term, term_instance_, j);
           current_term++;
         }
       } else if (oov_token_num == 1) {
-        CopyTermValue(term_instance, current_term, in_term_instance, i - 1);
+        term_instance->CopyFrom(current_term, in_term_instance, i - 1);
         current_term++;
       }
 
-      CopyTermValue(term_instance, current_term, in_term_instance, i);
+      term_instance->CopyFrom(current_term, in_term_instance, i);
       oov_begin_token = current_token + term_token_number;
       current_term++;
       oov_token_num = 0;
@@ -158,32 +203,18 @@ void OutOfVocabularyWordRecognizer::Recognize(
   if (oov_token_num > 1) {
     RecognizeRange(in_token_instance, oov_begin_token, current_token);
     for (int j = 0; j < term_instance_->size(); ++j) {
-      CopyTermValue(term_instance, current_term, term_instance_, j);
+      term_instance->CopyFrom(current_term, term_instance_, j);
       current_term++;
     }
   } else if (oov_token_num == 1) {
-    CopyTermValue(term_instance,
-                  current_term,
-                  in_term_instance,
-                  in_term_instance->size() - 1);
+    term_instance->CopyFrom(current_term,
+                            in_term_instance,
+                            in_term_instance->size() - 1);
     current_term++;
   }
 
   term_instance->set_size(current_term);
-}
-
-void OutOfVocabularyWordRecognizer::CopyTermValue(
-    TermInstance *dest_term_instance,
-    int dest_postion,
-    TermInstance *src_term_instance,
-    int src_position)  {
-
-  dest_term_instance->set_value_at(
-      dest_postion,
-      src_term_instance->term_text_at(src_position),
-      src_term_instance->token_number_at(src_position),
-      src_term_instance->term_type_at(src_position),
-      src_term_instance->term_id_at(src_position));
+  return true;
 }
 
 void OutOfVocabularyWordRecognizer::RecognizeRange(
@@ -31,12 +31,14 @@
 
 #include <stdint.h>
 #include <stdio.h>
+#include <vector>
 #include "common/milkcat_config.h"
 #include "util/util.h"
 
 namespace milkcat {
 
 class ReimuTrie;
+template <class T> class StaticArray;
 class CRFSegmenter;
 class TermInstance;
 class TokenInstance;
@@ -47,10 +49,19 @@ class OutOfVocabularyWordRecognizer {
    static OutOfVocabularyWordRecognizer *New(Model *model_factory,
                                              Status *status);
    ~OutOfVocabularyWordRecognizer();
-  void Recognize(TermInstance *term_instance,
+
+  // Recognizes the out-of-vocabulary words in spans of single-character words
+  // of `in_term_instance` by the CRF segmenter and stores the result into
+  // `term_instance`. If there is no such span, the result is the same as
+  // `in_term_instance`, so it just returns false and leaves `term_instance`
+  // unchanged
+  bool Recognize(TermInstance *term_instance,
                  TermInstance *in_term_instance,
                  TokenInstance *in_token_instance);
 
+  CRFSegmenter *crf_segmenter() const { return crf_segmenter_; }
+
+  static const int kOOVNoProperty = 0;
   static const int kOOVBeginOfWord = 1;
   static const int kOOVEndOfWord = 2;
   static const int kOOVFilteredWord = 3;
@@ -63,21 +74,21 @@ class OutOfVocabularyWordRecognizer {
   TermInstance *term_instance_;
   CRFSegmenter *crf_segmenter_;
   const ReimuTrie *oov_property_;
-  int8_t oov_properties_[kTokenMax];
+  const ReimuTrie *index_;
+  const StaticArray<uint8_t> *oov_property_by_term_id_;
+  std::vector<int8_t> oov_properties_;
 
   OutOfVocabularyWordRecognizer();
 
+  // Gets the oov property of the word at `position` of `term_instance`
+  int OOVPropertyAt(TermInstance *term_instance, int position) const;
+
   // Get the oov properties for term_instance, and write the result into
   // oov_properties_
   void GetOOVProperties(TermInstance *term_instance);
 
   void RecognizeRange(TokenInstance *token_instance, int begin, int end);
 
-  void CopyTermValue(TermInstance *dest_term_instance,
-                     int dest_postion,
-                     TermInstance *src_term_instance,
-                     int src_position);
-
   DISALLOW_COPY_AND_ASSIGN(OutOfVocabularyWordRecognizer);
 };
 
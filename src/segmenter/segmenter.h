@@ -40,6 +40,9 @@ class Segmenter {
   // Segment a token instance into term instance
   virtual void Segment(TermInstance *term_instance,
                        TokenInstance *token_instance) = 0;
+
+  // Releases the buffers grown by long sentences, they grow again on demand
+  virtual void Trim() {}
 };
 
 inline Segmenter::~Segmenter() {}
@@ -29,8 +29,10 @@
 
 namespace milkcat {
 
-TermInstance::TermInstance() {
-  instance_data_ = new InstanceData(1, 3, kTokenMax);
+TermInstance::TermInstance():
+    text_(kTokenMax),
+    span_text_(kTokenMax, static_cast<const char *>(NULL)) {
+  instance_data_ = new InstanceData(0, 5, kTokenMax, 1);
 }
 
 TermInstance::~TermInstance() {
@@ -28,7 +28,11 @@
 #ifndef SRC_SEGMENTER_TERM_INSTANCE_H_
 #define SRC_SEGMENTER_TERM_INSTANCE_H_
 
+#include <assert.h>
 #include <stdio.h>
+#include <algorithm>
+#include <string>
+#include <vector>
 #include "common/instance_data.h"
 #include "include/milkcat.h"
 #include "tokenizer/token_instance.h"
@@ -43,17 +47,25 @@ class TermInstance {
   TermInstance();
   ~TermInstance();
 
-  static const int kTermTextS = 0;
   static const int kTermTokenNumberI = 0;
   static const int kTermTypeI = 1;
   static const int kTermIdI = 2;
+  static const int kTermOffsetI = 3;
+  static const int kTermLengthI = 4;
+  static const int kTermConfidenceF = 0;
 
   static const int kTermIdNone = -2;
   static const int kTermIdOutOfVocabulary = -1;
 
-  // Get the term's string value at position
+  // Get the term's string value at position. For the term from tokens, its
+  // text is copied from the span of input text on the first call
   const char *term_text_at(int position) const {
-    return instance_data_->string_at(position, kTermTextS);
+    assert(position < size());
+    if (span_text_[position] != NULL) {
+      text_[position].assign(span_text_[position], term_length_at(position));
+      span_text_[position] = NULL;
+    }
+    return text_[position].c_str();
   }
 
   // Get the term type at position
@@ -76,27 +88,145 @@ class TermInstance {
     instance_data_->set_integer_at(position, kTermIdI, term_id);
   }
 
+  // Get the byte offset and length of the term at position in the text of
+  // its tokens. The offset is -1 if the term is not from tokens
+  int term_offset_at(int position) const {
+    return instance_data_->integer_at(position, kTermOffsetI);
+  }
+  int term_length_at(int position) const {
+    return instance_data_->integer_at(position, kTermLengthI);
+  }
+
+  // Get the posterior probability of the term at position estimated by the
+  // CRF segmenter, it is 1.0 when not estimated
+  float confidence_at(int position) const {
+    return instance_data_->float_at(position, kTermConfidenceF);
+  }
+
+  // Set the confidence at position, should be called after set_value_at
+  void set_confidence_at(int position, float confidence) {
+    instance_data_->set_float_at(position, kTermConfidenceF, confidence);
+  }
+
   // Set the size of this instance
-  void set_size(int size) { instance_data_->set_size(size); }
+  void set_size(int size) {
+    instance_data_->set_size(size);
+    ReserveText(size);
+  }
 
   // Get the size of this instance
   int size() const { return instance_data_->size(); }
 
+  // Swaps the terms of this instance with `other`
+  void Swap(TermInstance *other) {
+    std::swap(instance_data_, other->instance_data_);
+    text_.swap(other->text_);
+    span_text_.swap(other->span_text_);
+  }
+
   // Set the value at position
   void set_value_at(int position,
                     const char *term,
                     int token_number,
                     int term_type,
                     int term_id = kTermIdNone) {
-    instance_data_->set_string_at(position, kTermTextS, term);
-    instance_data_->set_integer_at(position, kTermTokenNumberI, token_number);
-    instance_data_->set_integer_at(position, kTermTypeI, term_type);
-    instance_data_->set_integer_at(position, kTermIdI, term_id);
+    ReserveText(position + 1);
+    text_[position] = term;
+    span_text_[position] = NULL;
+    set_integers_at(position, token_number, term_type, term_id, -1, 0);
+  }
+
+  // Set the value at position as the term of `token_number` tokens from
+  // `token_begin` in `token_instance`. Its text is not copied until
+  // term_text_at() is called, so the text of `token_instance` should be kept
+  // until then. If the tokenizer skipped bytes between the tokens, the text
+  // is joined from the tokens at once, and the span of term covers the
+  // skipped bytes
+  void set_value_at(int position,
+                    const TokenInstance *token_instance,
+                    int token_begin,
+                    int token_number,
+                    int term_type,
+                    int term_id = kTermIdNone) {
+    int token_end = token_begin + token_number;
+    int offset = token_instance->token_offset_at(token_begin);
+    int length = token_instance->token_offset_at(token_end - 1) +
+                 token_instance->token_length_at(token_end - 1) -
+                 offset;
+    int token_length = 0;
+    for (int i = token_begin; i < token_end; ++i) {
+      token_length += token_instance->token_length_at(i);
+    }
+
+    ReserveText(position + 1);
+    if (token_length == length) {
+      span_text_[position] = token_instance->text() + offset;
+    } else {
+      text_[position].clear();
+      for (int i = token_begin; i < token_end; ++i) {
+        text_[position] += token_instance->token_text_at(i);
+      }
+      span_text_[position] = NULL;
+    }
+    set_integers_at(position, token_number, term_type, term_id, offset,
+                    length);
+  }
+
+  // Copies the term and its confidence at `src_position` of `src` to
+  // position
+  void CopyFrom(int position, const TermInstance *src, int src_position) {
+    ReserveText(position + 1);
+    if (src->span_text_[src_position] != NULL) {
+      span_text_[position] = src->span_text_[src_position];
+    } else {
+      text_[position] = src->text_[src_position];
+      span_text_[position] = NULL;
+    }
+    set_integers_at(position,
+                    src->token_number_at(src_position),
+                    src->term_type_at(src_position),
+                    src->term_id_at(src_position),
+                    src->term_offset_at(src_position),
+                    src->term_length_at(src_position));
+    set_confidence_at(position, src->confidence_at(src_position));
+  }
+
+  // Replaces the text of term at position, e.g. after converting encoding
+  void set_term_text_at(int position, const char *term) {
+    text_[position] = term;
+    span_text_[position] = NULL;
   }
 
  private:
   InstanceData *instance_data_;
 
+  // The text of each term. If `span_text_` of a term is not NULL, its text is
+  // the span of input text from it and not copied into `text_` yet
+  mutable std::vector<std::string> text_;
+  mutable std::vector<const char *> span_text_;
+
+  void ReserveText(int size) {
+    if (size > static_cast<int>(text_.size())) {
+      size = std::max(size, static_cast<int>(text_.size()) * 2);
+      text_.resize(size);
+      span_text_.resize(size, static_cast<const char *>(NULL));
+    }
+  }
+
+  void set_integers_at(int position,
+                       int token_number,
+                       int term_type,
+                       int term_id,
+                       int offset,
+                       int length) {
+    instance_data_->set_integer_at(position, kTermTokenNumberI, token_number);
+    instance_data_->set_integer_at(position, kTermTypeI, term_type);
+    instance_data_->set_integer_at(position, kTermIdI, term_id);
+    instance_data_->set_integer_at(position, kTermOffsetI, offset);
+    instance_data_->set_integer_at(position, kTermLengthI, length);
+    instance_data_->set_float_at(position, kTermConfidenceF, 1.0f);
+  }
+
   DISALLOW_COPY_AND_ASSIGN(TermInstance);
 };
 
@@ -43,7 +43,6 @@ CRFPartOfSpeechTagger *CRFPartOfSpeechTagger::New(
   char error_message[1024];
   CRFPartOfSpeechTagger *self = new CRFPartOfSpeechTagger();
   
-  self->sequence_feature_set_ = new SequenceFeatureSet();
   self->crf_tagger_ = new CRFTagger(model);
   self->hmm_model_ = hmm_model;
 
@@ -81,15 +80,12 @@ CRFPartOfSpeechTagger *CRFPartOfSpeechTagger::New(
 }
 
 CRFPartOfSpeechTagger::CRFPartOfSpeechTagger(): crf_tagger_(NULL),
-                                                sequence_feature_set_(NULL),
+                                                term_instance_(NULL),
                                                 hmm_model_(NULL),
                                                 hmm_crf_ymap_(NULL) {
 }
 
 CRFPartOfSpeechTagger::~CRFPartOfSpeechTagger() {
-  delete sequence_feature_set_;
-  sequence_feature_set_ = NULL;
-
   delete crf_tagger_;
   crf_tagger_ = NULL;
 
@@ -97,21 +93,20 @@ CRFPartOfSpeechTagger::~CRFPartOfSpeechTagger() {
   hmm_crf_ymap_ = NULL;
 }
 
-void CRFPartOfSpeechTagger::TagRange(
-    PartOfSpeechTagInstance *tag_instance,
-    TermInstance *term_instance,
-    int begin,
-    int end) {
+void CRFPartOfSpeechTagger::Extract(SequenceFeatureSet *sequence_feature_set,
+                                    CRFTagger::Lattice *lattice,
+                                    int begin,
+                                    int end) {
   char buff[kFeatureLengthMax];
 
-  // Prepares the `sequence_feature_set_` for tagging
-  sequence_feature_set_->set_size(term_instance->size());
-  for (int idx = 0; idx < term_instance->size(); ++idx) {
-    int type = term_instance->term_type_at(idx);
-    const char *word = term_instance->term_text_at(idx);
+  // Prepares the `sequence_feature_set` for tagging
+  sequence_feature_set->set_size(end - begin);
+  for (int idx = begin; idx < end; ++idx) {
+    int type = term_instance_->term_type_at(idx);
+    const char *word = term_instance_->term_text_at(idx);
     int length = static_cast<int>(strlen(word));  
 
-    FeatureSet *feature_set = sequence_feature_set_->at_index(idx);
+    FeatureSet *feature_set = sequence_feature_set->at_index(idx - begin);
     feature_set->Clear();
 
     switch (type) {
@@ -151,12 +146,13 @@ void CRFPartOfSpeechTagger::TagRange(
 
   // Use the HMM emissions
   if (hmm_model_ != NULL) {
-    CRFTagger::Lattice *lattice = crf_tagger_->lattice();
-    for (int idx = 0; idx < term_instance->size(); ++idx) {
-      const char *word = term_instance->term_text_at(idx);
-      const HMMModel::EmissionArray *emission = hmm_model_->Emission(word);
-      lattice->Clear(idx);
-      int term_type = term_instance->term_type_at(idx);
+    for (int idx = begin; idx < end; ++idx) {
+      const char *word = term_instance_->term_text_at(idx);
+      const HMMModel::EmissionArray *emission = hmm_model_->Emission(
+          word,
+          term_instance_->term_id_at(idx));
+      lattice->Clear(idx - begin);
+      int term_type = term_instance_->term_type_at(idx);
 
       // If hmm model has emission for current word, put the emission_array
       // to lattice of crf_tagger_  
@@ -165,21 +161,41 @@ void CRFPartOfSpeechTagger::TagRange(
              emission_idx < emission->size();
              ++emission_idx) {
           int crf_tag = hmm_crf_ymap_[emission->yid_at(emission_idx)];
-          lattice->Add(idx, crf_tag);
+          lattice->Add(idx - begin, crf_tag);
         }
       } else if (term_type == Parser::kPunction) {
-        lattice->Add(idx, PU_);
+        lattice->Add(idx - begin, PU_);
       } else if (term_type == Parser::kOther) {
-        lattice->Add(idx, PU_);
+        lattice->Add(idx - begin, PU_);
       } else {
-        lattice->AllowAll(idx);
+        lattice->AllowAll(idx - begin);
       }
     }
   }
+}
+
+void CRFPartOfSpeechTagger::TagRange(
+    PartOfSpeechTagInstance *tag_instance,
+    TermInstance *term_instance,
+    int begin,
+    int end) {
+  // Only the terms near [begin, end) are extracted into the tagger
+  term_instance_ = term_instance;
+  crf_tagger_->TagRangeWindowed(this,
+                                term_instance->size(),
+                                begin,
+                                end,
+                                -1,
+                                -1);
+  term_instance_ = NULL;
 
-  crf_tagger_->TagRange(sequence_feature_set_, begin, end);
   for (int i = 0; i < end - begin; ++i) {
     tag_instance->set_value_at(i, crf_tagger_->yname(crf_tagger_->y(i)));
+    if (crf_tagger_->compute_marginals()) {
+      tag_instance->set_confidence_at(
+          i,
+          static_cast<float>(crf_tagger_->marginal(i)));
+    }
   }
   tag_instance->set_size(end - begin);
 }
@@ -42,7 +42,8 @@ class SequenceFeatureSet;
 class HMMModel;
 class Status;
 
-class CRFPartOfSpeechTagger: public PartOfSpeechTagger {
+class CRFPartOfSpeechTagger: public PartOfSpeechTagger,
+                             private CRFTagger::FeatureExtractor {
  public:
   static CRFPartOfSpeechTagger *New(
       const CRFModel *model, const HMMModel *hmm_model, Status *status);
@@ -50,6 +51,8 @@ class CRFPartOfSpeechTagger: public PartOfSpeechTagger {
 
   CRFTagger *crf_tagger() const { return crf_tagger_; }
 
+  void Trim() { crf_tagger_->Trim(); }
+
   // Tag the TermInstance and put the result to PartOfSpeechTagInstance
   void Tag(PartOfSpeechTagInstance *part_of_speech_tag_instance,
            TermInstance *term_instance) {
@@ -72,13 +75,22 @@ class CRFPartOfSpeechTagger: public PartOfSpeechTagger {
   };
 
   CRFTagger *crf_tagger_;
-  SequenceFeatureSet *sequence_feature_set_;
+
+  // The terms in tagging, for Extract()
+  TermInstance *term_instance_;
   const HMMModel *hmm_model_;
   int *hmm_crf_ymap_;
   int PU_;
 
   CRFPartOfSpeechTagger();
 
+  // Puts the terms [begin, end) of `term_instance_` into the tagger, it
+  // implements CRFTagger::FeatureExtractor
+  void Extract(SequenceFeatureSet *sequence_feature_set,
+               CRFTagger::Lattice *lattice,
+               int begin,
+               int end);
+
   DISALLOW_COPY_AND_ASSIGN(CRFPartOfSpeechTagger);
 };
 
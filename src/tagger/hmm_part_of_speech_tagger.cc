@@ -33,55 +33,36 @@
 #include <string>
 #include "common/model.h"
 #include "common/reimu_trie.h"
-#include "ml/beam.h"
 #include "ml/hmm_model.h"
 #include "segmenter/term_instance.h"
 #include "tagger/part_of_speech_tag_instance.h"
-#include "util/pool.h"
 #include "util/readable_file.h"
 #include "util/util.h"
 
 namespace milkcat {
 
-struct HMMPartOfSpeechTagger::Node {
-  int tag;
-  double cost;
-  const HMMPartOfSpeechTagger::Node *prevoius_node;
-
-  inline void set_value(int tag, double cost, const Node *prevoius_node) {
-    this->tag = tag;
-    this->cost = cost;
-    this->prevoius_node = prevoius_node;
-  } 
-};
-
-// Compare two node potiners by its cost value
-class HMMPartOfSpeechTagger::NodeComparator {
+// Compares the entries by their cost in `cost`, the lower one comes first
+class HMMPartOfSpeechTagger::CompareEntryByCost {
  public:
-  bool operator()(HMMPartOfSpeechTagger::Node *n1, 
-                  HMMPartOfSpeechTagger::Node *n2) {
-    return n1->cost < n2->cost;
+  CompareEntryByCost(const CostType *cost): cost_(cost) {}
+  bool operator()(int entry1, int entry2) const {
+    return cost_[entry1] < cost_[entry2];
   }
+ private:
+  const CostType *cost_;
 };
 
-HMMPartOfSpeechTagger::HMMPartOfSpeechTagger(): node_pool_(NULL),
+HMMPartOfSpeechTagger::HMMPartOfSpeechTagger(): beam_size_(kBeamSize),
+                                                transition_matrix_(NULL),
                                                 model_(NULL),
                                                 PU_emission_(NULL),
                                                 CD_emission_(NULL),
                                                 NN_emission_(NULL),
                                                 BOS_emission_(NULL),
                                                 term_instance_(NULL) {
-  node_pool_ = new Pool<Node>(); 
-
-  for (int i = 0; i < kMaxBeams; ++i) {
-    beams_[i] = new Beam<Node, NodeComparator>(kBeamSize);
-  }
 }
 
 HMMPartOfSpeechTagger::~HMMPartOfSpeechTagger() {
-  delete node_pool_;
-  node_pool_ = NULL;
-
   delete PU_emission_;
   PU_emission_ = NULL;
 
@@ -94,11 +75,8 @@ HMMPartOfSpeechTagger::~HMMPartOfSpeechTagger() {
   delete BOS_emission_;
   BOS_emission_ = NULL;
 
-  for (int i = 0; i < kMaxBeams; ++i) {
-    if (beams_[i] != NULL)
-      delete beams_[i];
-    beams_[i] = NULL;
-  }
+  delete[] transition_matrix_;
+  transition_matrix_ = NULL;
 }
 
 namespace {
@@ -148,6 +126,22 @@ HMMPartOfSpeechTagger *HMMPartOfSpeechTagger::New(
   HMMPartOfSpeechTagger *self = new HMMPartOfSpeechTagger();
   self->model_ = model;
 
+  // Back pointers of the lattice are bytes
+  int ysize = model->ysize();
+  if (ysize > 256) {
+    *status = Status::Corruption("too many tags in HMM model");
+  }
+
+  if (status->ok()) {
+    self->transition_matrix_ = new CostType[ysize * ysize];
+    for (int left = 0; left < ysize; ++left) {
+      for (int right = 0; right < ysize; ++right) {
+        self->transition_matrix_[left * ysize + right] = model->cost(left,
+                                                                     right);
+      }
+    }
+  }
+
   if (status->ok()) {
     self->PU_emission_ = NewEmission("PU", self->model_, status);
   } 
@@ -171,7 +165,8 @@ HMMPartOfSpeechTagger *HMMPartOfSpeechTagger::New(
 
 const HMMModel::EmissionArray *HMMPartOfSpeechTagger::EmissionAt(int position) {
   const HMMModel::EmissionArray *emission = NULL;
-  emission = model_->Emission(term_instance_->term_text_at(position));
+  emission = model_->Emission(term_instance_->term_text_at(position),
+                              term_instance_->term_id_at(position));
 
   if (emission == NULL) {
     int term_type = term_instance_->term_type_at(position);
@@ -195,23 +190,18 @@ const HMMModel::EmissionArray *HMMPartOfSpeechTagger::EmissionAt(int position) {
 
 inline void HMMPartOfSpeechTagger::StoreResult(
     PartOfSpeechTagInstance *tag_instance) {
-  int beam_idx = term_instance_->size() + 1;
-
-  // `beams_[beam_idx]` should have only one BOS node
-  MC_ASSERT(beams_[beam_idx]->size() == 1, "last node in beam should be -BOS-");
-  const Node *node = beams_[beam_idx]->at(0);
-
-  int position = term_instance_->size() - 1;
-
-  // Ignores the last BOS node
-  node = node->prevoius_node;
-  while (node->prevoius_node != NULL) {
-    tag_instance->set_value_at(position, model_->yname(node->tag));
-    position--;
-    node = node->prevoius_node;
+  int size = term_instance_->size();
+
+  // The last position should have only one BOS entry
+  MC_ASSERT(offset_[size + 2] - offset_[size + 1] == 1,
+            "last entry should be -BOS-");
+  int entry = offset_[size + 1];
+  for (int position = size; position > 0; --position) {
+    entry = offset_[position] + back_[entry];
+    tag_instance->set_value_at(position - 1, model_->yname(tag_[entry]));
   }
 
-  tag_instance->set_size(term_instance_->size());
+  tag_instance->set_size(size);
 }
 
 void HMMPartOfSpeechTagger::Tag(
@@ -219,52 +209,62 @@ void HMMPartOfSpeechTagger::Tag(
     TermInstance *term_instance) {
   term_instance_ = term_instance;
 
-  Node *begin_node = node_pool_->Alloc();
-  begin_node->set_value(HMMModel::kBeginOfSenetnceId, 0, NULL);
-  beams_[0]->Clear();
-  beams_[0]->Add(begin_node);
+  // The BOS entry
+  offset_.resize(term_instance->size() + 3);
+  tag_.assign(1, HMMModel::kBeginOfSenetnceId);
+  cost_.assign(1, 0.0);
+  back_.assign(1, 0);
+  offset_[0] = 0;
+  offset_[1] = 1;
 
   // Viterbi algorithm
   const HMMModel::EmissionArray *emission = NULL;
   for (int idx = 0; idx < term_instance->size(); ++idx) {
     emission = EmissionAt(idx);
-    // beam_[0] is the BOS node, so use `idx + 1` for the word at `idx`
+    // Position 0 is the BOS, so use `idx + 1` for the word at `idx`
     Step(idx + 1, emission);
   }
 
-  // The last BOS node
+  // The last BOS
   emission = BOS_emission_;
   Step(term_instance->size() + 1, emission);
 
   // Save the result into `part_of_speech_tag_instance`
   StoreResult(part_of_speech_tag_instance);
-
-  node_pool_->ReleaseAll();
 }
 
 void HMMPartOfSpeechTagger::Step(int position,
                                  const HMMModel::EmissionArray *emission) {
-  Beam<Node, NodeComparator> *previous_beam = beams_[position - 1];
-  Beam<Node, NodeComparator> *beam = beams_[position];
-
-  previous_beam->Shrink();
-  beam->Clear();
+  int ysize = model_->ysize();
+  int prev_offset = offset_[position - 1];
+  int prev_size = offset_[position] - prev_offset;
+  const CostType *prev_cost = &cost_[prev_offset];
+
+  // Keeps the best `beam_size_` entries of previous position
+  kept_.resize(prev_size);
+  for (int i = 0; i < prev_size; ++i) kept_[i] = i;
+  if (beam_size_ > 0 && prev_size > beam_size_) {
+    std::partial_sort(kept_.begin(),
+                      kept_.begin() + beam_size_,
+                      kept_.end(),
+                      CompareEntryByCost(prev_cost));
+    kept_.resize(beam_size_);
+  }
 
   for (int emission_idx = 0; emission_idx < emission->size(); ++emission_idx) {
-    double min_cost = 1e38;
-    const Node *min_node = NULL;
+    CostType min_cost = 1e38;
+    int min_entry = 0;
     int tag = emission->yid_at(emission_idx);
-    double emission_cost = emission->cost_at(emission_idx);
-
-    // To find the best path for current node
-    for (int i = 0; i < previous_beam->size(); ++i) {
-      const Node *left_node = previous_beam->at(i);
-      int left_tag = left_node->tag;
-      double transition_cost = model_->cost(left_tag, tag);
-      double cost = left_node->cost + transition_cost + emission_cost;
+    CostType emission_cost = emission->cost_at(emission_idx);
+
+    // To find the best path for current tag
+    for (size_t i = 0; i < kept_.size(); ++i) {
+      int left_tag = tag_[prev_offset + kept_[i]];
+      CostType transition_cost = transition_matrix_[left_tag * ysize + tag];
+      CostType cost = prev_cost[kept_[i]] + transition_cost + emission_cost;
       if (cost < min_cost) {
         min_cost = cost;
-        min_node = left_node;
+        min_entry = kept_[i];
       }
       LOG("word = %s, left_tag = %s, tag = %s, emission_cost = %f, "
           "transition_cost = %f, total_cost = %f\n",
@@ -276,10 +276,11 @@ void HMMPartOfSpeechTagger::Step(int position,
           transition_cost,
           cost);
     }
-    Node *node = node_pool_->Alloc();
-    node->set_value(tag, min_cost, min_node);
-    beam->Add(node); 
+    tag_.push_back(tag);
+    cost_.push_back(min_cost);
+    back_.push_back(static_cast<unsigned char>(min_entry));
   }
+  offset_[position + 1] = tag_.size();
 }
 
 void HMMPartOfSpeechTagger::Train(
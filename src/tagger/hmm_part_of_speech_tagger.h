@@ -27,6 +27,7 @@
 #ifndef SRC_TAGGER_HMM_PART_OF_SPEECH_TAGGER_H_
 #define SRC_TAGGER_HMM_PART_OF_SPEECH_TAGGER_H_
 
+#include <vector>
 #include "common/milkcat_config.h"
 #include "ml/hmm_model.h"
 #include "tagger/part_of_speech_tagger.h"
@@ -36,18 +37,12 @@ namespace milkcat {
 
 class PartOfSpeechTagInstance;
 class TermInstance;
-template<class T, class Comparator> class Beam;
 class Model;
-template<class T> class Pool;
 
 // HMMPartOfSpeechTagger uses Hidden Markov Model to predict the part-of-speech
 // tag of given TermInstance
 class HMMPartOfSpeechTagger: public PartOfSpeechTagger {
  public:
-  struct Node;
-
-  // Beam size, two position for BOS node
-  static const int kMaxBeams = kTokenMax + 2;
   static const int kBeamSize = 3;
 
   ~HMMPartOfSpeechTagger();
@@ -63,11 +58,30 @@ class HMMPartOfSpeechTagger: public PartOfSpeechTagger {
                     const char *model_filename,
                     Status *status);
 
- private:
-  class NodeComparator;
+  // Sets the beam size of Viterbi. Only the best `beam_size` tags of each
+  // position are the left tags of next position, 0 keeps all of them (the
+  // exact Viterbi). Default is kBeamSize
+  void set_beam_size(int beam_size) { beam_size_ = beam_size; }
+  int beam_size() const { return beam_size_; }
 
-  Beam<Node, NodeComparator> *beams_[kMaxBeams];
-  Pool<Node> *node_pool_;
+ private:
+  class CompareEntryByCost;
+
+  // The Viterbi lattice in flat arrays, position 0 and size + 1 are the BOS.
+  // The entries of `position` are [offset_[position], offset_[position + 1]),
+  // an entry is a candidate tag with its cost and the index of the entry it
+  // comes from, relative to the offset of previous position
+  std::vector<int> offset_;
+  std::vector<int> tag_;
+  std::vector<CostType> cost_;
+  std::vector<unsigned char> back_;
+
+  // Entries of previous position kept by the beam, relative to its offset
+  std::vector<int> kept_;
+  int beam_size_;
+
+  // The transition costs of model as a [left][right] matrix
+  CostType *transition_matrix_;
 
   const HMMModel *model_;
 
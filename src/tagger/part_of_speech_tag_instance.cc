@@ -30,7 +30,7 @@
 namespace milkcat {
 
 PartOfSpeechTagInstance::PartOfSpeechTagInstance() {
-  instance_data_ = new InstanceData(1, 1, kTokenMax);
+  instance_data_ = new InstanceData(1, 1, kTokenMax, 1);
 }
 
 PartOfSpeechTagInstance::~PartOfSpeechTagInstance() {
@@ -42,6 +42,7 @@ class PartOfSpeechTagInstance {
 
   static const int kPOSTagS = 0;
   static const int kOutOfVocabularyI = 0;
+  static const int kConfidenceF = 0;
 
   const char *part_of_speech_tag_at(int position) const {
     return instance_data_->string_at(position, kPOSTagS);
@@ -53,6 +54,17 @@ class PartOfSpeechTagInstance {
     return instance_data_->integer_at(position, kOutOfVocabularyI) != 0;
   }
 
+  // Get the posterior probability of the tag at position estimated by the
+  // CRF tagger, it is 1.0 when not estimated
+  float confidence_at(int position) const {
+    return instance_data_->float_at(position, kConfidenceF);
+  }
+
+  // Set the confidence at position, should be called after set_value_at
+  void set_confidence_at(int position, float confidence) {
+    instance_data_->set_float_at(position, kConfidenceF, confidence);
+  }
+
   // Set the size of this instance
   void set_size(int size) { instance_data_->set_size(size); }
 
@@ -63,6 +75,7 @@ class PartOfSpeechTagInstance {
   void set_value_at(int position, const char *tag, bool is_oov = true) {
     instance_data_->set_string_at(position, kPOSTagS, tag);
     instance_data_->set_integer_at(position, kOutOfVocabularyI, is_oov);
+    instance_data_->set_float_at(position, kConfidenceF, 1.0f);
   }
 
  private:
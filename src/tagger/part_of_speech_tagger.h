@@ -43,6 +43,9 @@ class PartOfSpeechTagger {
   virtual void Tag(PartOfSpeechTagInstance *part_of_speech_tag_instance,
                    TermInstance *term_instance) = 0;
 
+  // Releases the buffers grown by long sentences, they grow again on demand
+  virtual void Trim() {}
+
   // Reads a tagged instance from corpus and stores it into `term_instance` and
   // `tag_instance`
   static void ReadInstance(ReadableFile *fd,
@@ -29,8 +29,8 @@
 
 namespace milkcat {
 
-TokenInstance::TokenInstance() {
-  instance_data_ = new InstanceData(1, 1, kTokenMax);
+TokenInstance::TokenInstance(): text_(""), text_offset_(0) {
+  instance_data_ = new InstanceData(0, 4, kTokenMax);
 }
 
 TokenInstance::~TokenInstance() {
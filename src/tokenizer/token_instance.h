@@ -28,6 +28,8 @@
 #define SRC_TOKENIZER_TOKEN_INSTANCE_H_
 
 #include <assert.h>
+#include <stdint.h>
+#include <vector>
 #include "common/instance_data.h"
 #include "common/milkcat_config.h"
 #include "util/util.h"
@@ -54,11 +56,36 @@ class TokenInstance {
 
 
   static const int kTokenTypeI = 0;
-  static const int kTokenUTF8S = 0;
+  static const int kTokenOffsetI = 1;
+  static const int kTokenLengthI = 2;
+  static const int kTokenTextI = 3;
 
   // Get the token's string value at position
   const char *token_text_at(int position) const {
-    return instance_data_->string_at(position, kTokenUTF8S);
+    return &token_text_[instance_data_->integer_at(position, kTokenTextI)];
+  }
+
+  // Get the byte offset and length of the token at position in text()
+  int token_offset_at(int position) const {
+    return instance_data_->integer_at(position, kTokenOffsetI);
+  }
+  int token_length_at(int position) const {
+    return instance_data_->integer_at(position, kTokenLengthI);
+  }
+
+  // Get the text which the tokens are from
+  const char *text() const { return text_; }
+
+  // Get the byte offset of text() in the whole input. It is not 0 when the
+  // input is a stream and text() is a part of it
+  int64_t text_offset() const { return text_offset_; }
+
+  // Clears the tokens and sets the text which the tokens are from, and its
+  // byte offset in the whole input
+  void set_text(const char *text, int64_t text_offset) {
+    text_ = text;
+    text_offset_ = text_offset;
+    token_text_.clear();
   }
 
   // Get the token type at position
@@ -72,14 +99,26 @@ class TokenInstance {
   // Get the size of this instance
   int size() const { return instance_data_->size(); }
 
-  // Set the value at position
-  void set_value_at(int position, const char *token_text, int token_type) {
-    instance_data_->set_string_at(position, kTokenUTF8S, token_text);
+  // Set the token at position as `length` bytes from `offset` in text(). The
+  // NUL-terminated texts of tokens are kept together in one buffer
+  void set_value_at(int position, int offset, int length, int token_type) {
     instance_data_->set_integer_at(position, kTokenTypeI, token_type);
+    instance_data_->set_integer_at(position, kTokenOffsetI, offset);
+    instance_data_->set_integer_at(position, kTokenLengthI, length);
+    instance_data_->set_integer_at(position,
+                                   kTokenTextI,
+                                   static_cast<int>(token_text_.size()));
+    token_text_.insert(token_text_.end(),
+                       text_ + offset,
+                       text_ + offset + length);
+    token_text_.push_back('\0');
   }
 
  private:
   InstanceData *instance_data_;
+  const char *text_;
+  int64_t text_offset_;
+  std::vector<char> token_text_;
   DISALLOW_COPY_AND_ASSIGN(TokenInstance);
 };
 
@@ -25,51 +25,399 @@
 // tokenizer.cc --- Created at 2013-12-24
 //
 
+
 #include "tokenizer/tokenizer.h"
 
-#include <stdio.h>
+#include <string.h>
+#include <algorithm>
 #include "common/milkcat_config.h"
 #include "tokenizer/token_instance.h"
-#include "tokenizer/token_lex.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MILKCAT_SSE2_TOKENIZER
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
 
 namespace milkcat {
 
-Tokenizer::Tokenizer(): buffer_alloced_(false) {
-  milkcat_yylex_init(&yyscanner);
+namespace {
+
+// ReadToken() returns it for a byte which is not valid UTF-8
+const int kInvalidToken = -1;
+
+// The number of bytes after a token to make sure that it and the character
+// after it are not cut by the end of a chunk. The longest character is "ＷＸ"
+const int kLookaheadSize = 6;
+
+// Classes of the characters in text. The letters are used in kAsciiClass
+enum CharClass {
+  kOtherChar = 'o',
+  kAlphaChar = 'a',
+  kDigitChar = 'd',
+  kPunctionChar = 'p',      // Symbols that could be part of a kSymbol token
+  kPunctuationChar = 'u',
+  kPeriodChar = '.',
+  kSpaceChar = 's',
+  kCrLfChar = 'c',
+  kChineseChar = 'h',
+  kInvalidChar = 'x'
+};
+
+// Class of each ASCII character
+const char kAsciiClass[] =
+    "oooooooooscoocoo"    // 0x00
+    "oooooooooooooooo"    // 0x10
+    "spupoppuoooouppp"    // 0x20  !"#$%&'()*+,-./
+    "ddddddddddpoopop"    // 0x30 0123456789:;<=>?
+    "paaaaaaaaaaaaaaa"    // 0x40 @ABCDEFGHIJKLMNO
+    "aaaaaaaaaaaopooo"    // 0x50 PQRSTUVWXYZ[\]^_
+    "oaaaaaaaaaaaaaaa"    // 0x60 `abcdefghijklmno
+    "aaaaaaaaaaaooopo";   // 0x70 pqrstuvwxyz{|}~
+
+inline CharClass AsciiClass(int ch) {
+  return static_cast<CharClass>(kAsciiClass[ch]);
+}
+
+inline bool IsTrailByte(unsigned char ch) { return (ch & 0xc0) == 0x80; }
+
+// Class of the fullwidth form U+FF01 to U+FF5E of ASCII character `ch`. `p`
+// points to its UTF-8 bytes and there are `size` bytes from `p`
+CharClass FullwidthClass(const unsigned char *p,
+                         int size,
+                         int ch,
+                         int *length) {
+  switch (AsciiClass(ch)) {
+    case kDigitChar:
+      return kDigitChar;
+    case kAlphaChar:
+      // The alphabet of the former flex scanner had "Ｗ\Ｘ" in place of
+      // "Ｗ|Ｘ", so only "ＷＸ" is a letter. Kept to give the same tokens
+      if (ch != 'W' && ch != 'X') return kAlphaChar;
+      if (ch == 'W' && size >= 6 &&
+          p[3] == 0xef && p[4] == 0xbc && p[5] == 0xb8) {
+        *length = 6;
+        return kAlphaChar;
+      }
+      return kOtherChar;
+    default:
+      if (ch == '!' || ch == '?') return kPeriodChar;
+      if (ch == ',') return kPunctuationChar;
+      return kOtherChar;
+  }
 }
 
-Tokenizer::~Tokenizer() {
-  if (buffer_alloced_ == true) {
-    milkcat_yy_delete_buffer(yy_buffer_state_, yyscanner);
+// Reads the character at `p` before `end`, stores its length in bytes into
+// `length` and returns its class. The length of an invalid byte is 1
+CharClass ReadChar(const char *text, const char *end, int *length) {
+  const unsigned char *p = reinterpret_cast<const unsigned char *>(text);
+  int size = static_cast<int>(end - text);
+  if (p[0] < 0x80) {
+    *length = 1;
+    return AsciiClass(p[0]);
+  } else if (p[0] >= 0xe0 && p[0] <= 0xef) {
+    if (size < 3 || !IsTrailByte(p[1]) || !IsTrailByte(p[2])) {
+      *length = 1;
+      return kInvalidChar;
+    }
+    *length = 3;
+    int code_point = (p[0] & 0x0f) << 12 | (p[1] & 0x3f) << 6 | (p[2] & 0x3f);
+    if (code_point >= 0x4e00 && code_point <= 0x9fa5) {
+      return kChineseChar;
+    } else if (code_point >= 0xff01 && code_point <= 0xff5e) {
+      return FullwidthClass(p, size, code_point - 0xfee0, length);
+    } else if (code_point == 0x3002) {  // 。
+      return kPeriodChar;
+    } else if (code_point == 0x201c || code_point == 0x201d) {  // “ ”
+      return kPunctuationChar;
+    } else {
+      return kOtherChar;
+    }
+  } else if (p[0] >= 0xc2 && p[0] <= 0xdf && size >= 2 &&
+             IsTrailByte(p[1])) {
+    *length = 2;
+    return p[0] == 0xc2 && p[1] == 0xb7 ? kPunctuationChar : kOtherChar;  // ·
+  } else if (p[0] >= 0xf0 && p[0] <= 0xf4 && size >= 4 &&
+             IsTrailByte(p[1]) && IsTrailByte(p[2]) && IsTrailByte(p[3])) {
+    *length = 4;
+    return kOtherChar;
+  } else {
+    *length = 1;
+    return kInvalidChar;
   }
+}
 
-  milkcat_yylex_destroy(yyscanner);
+#ifdef MILKCAT_SSE2_TOKENIZER
+inline int CountTrailingZeros(unsigned value) {
+#ifdef _MSC_VER
+  unsigned long index;
+  _BitScanForward(&index, value);
+  return static_cast<int>(index);
+#else
+  return __builtin_ctz(value);
+#endif
 }
+#endif  // MILKCAT_SSE2_TOKENIZER
 
-void Tokenizer::Scan(const char *buffer_string) {
-  if (buffer_alloced_ == true) {
-    milkcat_yy_delete_buffer(yy_buffer_state_, yyscanner);
+// Returns the length of the run of ASCII letters and digits at `p` before
+// `end`, and sets `has_alpha` or `has_digit` if there is any letter or digit
+// in it
+int AlnumRun(const char *p,
+             const char *end,
+             bool *has_alpha,
+             bool *has_digit) {
+  int size = static_cast<int>(end - p);
+  int length = 0;
+#ifdef MILKCAT_SSE2_TOKENIZER
+  const __m128i case_bit = _mm_set1_epi8(0x20);
+  const __m128i before_a = _mm_set1_epi8('a' - 1);
+  const __m128i after_z = _mm_set1_epi8('z' + 1);
+  const __m128i before_0 = _mm_set1_epi8('0' - 1);
+  const __m128i after_9 = _mm_set1_epi8('9' + 1);
+  while (size - length >= 16) {
+    // Bytes larger than 0x7f are negative in the signed comparisons
+    __m128i block = _mm_loadu_si128(
+        reinterpret_cast<const __m128i *>(p + length));
+    __m128i lower = _mm_or_si128(block, case_bit);
+    int alpha_mask = _mm_movemask_epi8(
+        _mm_and_si128(_mm_cmpgt_epi8(lower, before_a),
+                      _mm_cmplt_epi8(lower, after_z)));
+    int digit_mask = _mm_movemask_epi8(
+        _mm_and_si128(_mm_cmpgt_epi8(block, before_0),
+                      _mm_cmplt_epi8(block, after_9)));
+    int mask = alpha_mask | digit_mask;
+    int run = mask == 0xffff ? 16 : CountTrailingZeros(~mask);
+    int run_mask = (1 << run) - 1;
+    if (alpha_mask & run_mask) *has_alpha = true;
+    if (digit_mask & run_mask) *has_digit = true;
+    length += run;
+    if (run < 16) return length;
   }
-  buffer_alloced_ = true;
-  yy_buffer_state_ = milkcat_yy_scan_string(buffer_string, yyscanner);
+#endif  // MILKCAT_SSE2_TOKENIZER
+
+  // Bytes at the end of text, or all of them without SSE2
+  for (; length < size; ++length) {
+    unsigned char ch = static_cast<unsigned char>(p[length]);
+    CharClass char_class = ch < 0x80? AsciiClass(ch): kOtherChar;
+    if (char_class == kAlphaChar) {
+      *has_alpha = true;
+    } else if (char_class == kDigitChar) {
+      *has_digit = true;
+    } else {
+      return length;
+    }
+  }
+  return length;
+}
+
+// Returns true if the text from `p` to `end` is DIGIT+(\.DIGIT+)?
+bool IsNumber(const char *p, const char *end) {
+  bool digit_seen = false, period_seen = false;
+  while (p < end) {
+    int length;
+    if (ReadChar(p, end, &length) == kDigitChar) {
+      digit_seen = true;
+    } else if (*p == '.' && digit_seen && !period_seen) {
+      digit_seen = false;
+      period_seen = true;
+    } else {
+      return false;
+    }
+    p += length;
+  }
+  return digit_seen;
+}
+
+// Reads the longest run of letters, digits and punctions at `p` before `end`,
+// stores its length into `length` and returns its type. Like the
+// former flex scanner, a single character is a number, English word or
+// punctuation. For longer ones, letters are an English word, text matching
+// DIGIT+(\.DIGIT+)? is a number and others are symbols
+int ReadBlock(const char *p, const char *end, int *length) {
+  const char *q = p;
+  int char_number = 0;
+  bool has_alpha = false, has_digit = false, has_punction = false;
+  CharClass first_class = kOtherChar;
+  while (q < end) {
+    int char_length;
+    CharClass char_class = ReadChar(q, end, &char_length);
+    if (char_number == 0) first_class = char_class;
+
+    if (char_length == 1 &&
+        (char_class == kAlphaChar || char_class == kDigitChar)) {
+      int run = AlnumRun(q, end, &has_alpha, &has_digit);
+      char_number += run;
+      q += run;
+    } else if (char_class == kAlphaChar) {
+      has_alpha = true;
+      char_number++;
+      q += char_length;
+    } else if (char_class == kDigitChar) {
+      has_digit = true;
+      char_number++;
+      q += char_length;
+    } else if (char_class == kPunctionChar) {
+      has_punction = true;
+      char_number++;
+      q += char_length;
+    } else {
+      break;
+    }
+  }
+
+  *length = static_cast<int>(q - p);
+  if (char_number == 1) {
+    switch (first_class) {
+      case kAlphaChar: return TokenInstance::kEnglishWord;
+      case kDigitChar: return TokenInstance::kNumber;
+      default: return TokenInstance::kPunctuation;
+    }
+  } else if (!has_digit && !has_punction) {
+    return TokenInstance::kEnglishWord;
+  } else if (!has_alpha && IsNumber(p, q)) {
+    return TokenInstance::kNumber;
+  } else {
+    return TokenInstance::kSymbol;
+  }
+}
+
+// Reads the token at `p` before `end`, stores its length into `length` and
+// returns its type. `p` should be less than `end`
+int ReadToken(const char *p, const char *end, int *length) {
+  CharClass char_class = ReadChar(p, end, length);
+  switch (char_class) {
+    case kAlphaChar:
+    case kDigitChar:
+    case kPunctionChar:
+      return ReadBlock(p, end, length);
+
+    case kSpaceChar:
+    case kCrLfChar:
+      while (p + *length < end &&
+             static_cast<unsigned char>(p[*length]) < 0x80 &&
+             AsciiClass(p[*length]) == char_class) {
+        ++*length;
+      }
+      return char_class == kSpaceChar? TokenInstance::kSpace:
+                                       TokenInstance::kCrLf;
+
+    case kChineseChar:
+      return TokenInstance::kChineseChar;
+    case kPeriodChar:
+      return TokenInstance::kPeriod;
+    case kPunctuationChar:
+      return TokenInstance::kPunctuation;
+    case kInvalidChar:
+      return kInvalidToken;
+    default:
+      return TokenInstance::kOther;
+  }
+}
+
+}  // namespace
+
+Tokenizer::Tokenizer():
+    text_(""),
+    text_length_(0),
+    position_(0),
+    text_offset_(0),
+    reader_(NULL),
+    stream_end_(false) {
+}
+
+void Tokenizer::Scan(const char *text, int length) {
+  buffer_.assign(text, text + length);
+  ScanInPlace(buffer_.empty()? "": buffer_.data(), length);
+}
+
+void Tokenizer::ScanInPlace(const char *text, int length) {
+  text_ = text;
+  text_length_ = length;
+  position_ = 0;
+  text_offset_ = 0;
+  reader_ = NULL;
+}
+
+void Tokenizer::ScanStream(Parser::Reader *reader) {
+  // `buffer_` is never resized during scanning, so the tokens of current
+  // sentence are kept
+  buffer_.resize(kStreamBufferSize);
+  text_ = buffer_.data();
+  text_length_ = 0;
+  position_ = 0;
+  text_offset_ = 0;
+  reader_ = reader;
+  stream_end_ = false;
+}
+
+bool Tokenizer::ReadChunk() {
+  int size = std::min(kStreamChunkSize, kStreamBufferSize - text_length_);
+  if (stream_end_ || size == 0) return false;
+
+  int read_size = reader_->Read(buffer_.data() + text_length_, size);
+  if (read_size <= 0) {
+    stream_end_ = true;
+    return false;
+  }
+  text_length_ += read_size;
+  return true;
+}
+
+void Tokenizer::CompactBuffer() {
+  memmove(buffer_.data(),
+          buffer_.data() + position_,
+          text_length_ - position_);
+  text_length_ -= position_;
+  text_offset_ += position_;
+  position_ = 0;
 }
 
 bool Tokenizer::GetSentence(TokenInstance *token_instance) {
-  int token_type;
   int token_count = 0;
+  token_instance->set_text(text_, text_offset_);
+
+  // The sentence is not limited in length, `token_instance` grows as needed.
+  // For a stream, it is limited by the size of buffer
+  for (;;) {
+    // Before the first token, the text of previous sentence could be removed
+    // to make space for the next chunk
+    if (reader_ != NULL && token_count == 0 &&
+        kStreamBufferSize - text_length_ < kStreamChunkSize) {
+      CompactBuffer();
+      token_instance->set_text(text_, text_offset_);
+    }
+    if (position_ == text_length_ && (reader_ == NULL || !ReadChunk())) break;
 
-  while (token_count < kTokenMax - 1) {
-    token_type = milkcat_yylex(yyscanner);
+    int length;
+    int token_type = ReadToken(text_ + position_,
+                               text_ + text_length_,
+                               &length);
 
-    if (token_type == TokenInstance::kEnd) break;
+    // The token read from a stream is not complete until there are enough
+    // bytes after it. If the buffer is full, the sentence is split here
+    bool buffer_full = false;
+    if (reader_ != NULL && !stream_end_ &&
+        position_ + length + kLookaheadSize > text_length_) {
+      if (ReadChunk()) continue;
+      buffer_full = !stream_end_;
+    }
 
-    token_instance->set_value_at(token_count,
-                                 milkcat_yyget_text(yyscanner),
-                                 token_type);
-    token_count++;
+    // Bytes which are not valid UTF-8 are skipped
+    if (token_type != kInvalidToken) {
+      token_instance->set_value_at(token_count,
+                                   position_,
+                                   length,
+                                   token_type);
+      token_count++;
+    }
+    position_ += length;
 
     if (token_type == TokenInstance::kPeriod ||
-        token_type == TokenInstance::kCrLf)
+        token_type == TokenInstance::kCrLf ||
+        buffer_full)
       break;
   }
 
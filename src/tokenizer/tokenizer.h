@@ -28,26 +28,66 @@
 #ifndef SRC_TOKENIZER_TOKENIZER_H_
 #define SRC_TOKENIZER_TOKENIZER_H_
 
-#include "tokenizer/token_lex.h"
+#include <stdint.h>
+#include <vector>
+#include "include/milkcat.h"
 
 namespace milkcat {
 
 class TokenInstance;
 
+// Splits text into tokens (Chinese characters, numbers, English words, ...)
+// and sentences. A sentence ends with a period, question mark, exclamation
+// mark or line break
 class Tokenizer {
  public:
+  // The size of chunks read from stream and the size of buffer for stream
+  static const int kStreamChunkSize = 64 * 1024;
+  static const int kStreamBufferSize = 1024 * 1024;
+
   Tokenizer();
-  ~Tokenizer();
 
-  // Scan an string to get tokens
-  void Scan(const char *buffer_string);
+  // Scans `length` bytes of text to get tokens. The text is copied into this
+  // tokenizer, so it could be released after Scan()
+  void Scan(const char *text, int length);
+
+  // Scans `length` bytes of text without copying it, so the text should be
+  // kept unchanged until the tokens of the last sentence are used up. It
+  // needs not end with NUL
+  void ScanInPlace(const char *text, int length);
 
+  // Scans the text from `reader` chunk by chunk in a buffer of fixed size.
+  // The characters and tokens cut by chunks are joined, but sentences longer
+  // than about kStreamBufferSize bytes are split
+  void ScanStream(Parser::Reader *reader);
+
+  // Gets the tokens of next sentence, they are the spans of the scanned text.
+  // Returns false if the end of text is reached
   bool GetSentence(TokenInstance *token_instance);
 
  private:
-  YY_BUFFER_STATE yy_buffer_state_;
-  yyscan_t yyscanner;
-  bool buffer_alloced_;
+  // The text being scanned and offset of the next token in it
+  const char *text_;
+  int text_length_;
+  int position_;
+
+  // The byte offset of `text_` in the whole input, it is increased when the
+  // buffer of stream is compacted
+  int64_t text_offset_;
+
+  // The copy of text made by Scan(), or the buffer of ScanStream()
+  std::vector<char> buffer_;
+
+  // The stream being scanned, NULL if scanning a text
+  Parser::Reader *reader_;
+  bool stream_end_;
+
+  // Reads a chunk from `reader_` to the end of `buffer_`. Returns false if
+  // the stream is ended or the buffer is full
+  bool ReadChunk();
+
+  // Removes the text before `position_` from the buffer of stream
+  void CompactBuffer();
 };
 
 }  // namespace milkcat
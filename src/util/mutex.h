@@ -0,0 +1,70 @@
+//
+// The MIT License (MIT)
+//
+// Copyright 2013-2014 The MilkCat Project Developers
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// mutex.h --- Created at 2015-03-18
+//
+
+#ifndef SRC_UTIL_MUTEX_H_
+#define SRC_UTIL_MUTEX_H_
+
+#include "util/util.h"
+
+namespace milkcat {
+
+// A non-recursive mutex for the data shared by threads
+class Mutex {
+ public:
+  class Impl;
+
+  Mutex();
+  ~Mutex();
+
+  void Lock();
+  void Unlock();
+
+ private:
+  Impl *impl_;
+
+  DISALLOW_COPY_AND_ASSIGN(Mutex);
+};
+
+// Locks the mutex in the scope of this instance. `mutex` could be NULL, then
+// it does nothing
+class MutexLock {
+ public:
+  explicit MutexLock(Mutex *mutex): mutex_(mutex) {
+    if (mutex_ != NULL) mutex_->Lock();
+  }
+  ~MutexLock() {
+    if (mutex_ != NULL) mutex_->Unlock();
+  }
+
+ private:
+  Mutex *mutex_;
+
+  DISALLOW_COPY_AND_ASSIGN(MutexLock);
+};
+
+}  // namespace milkcat
+
+#endif  // SRC_UTIL_MUTEX_H_
@@ -3,9 +3,12 @@
 %{
 
 #include <stdbool.h>
+#include <stdint.h>
 
 %}
 
+%include "stdint.i"
+
 typedef struct milkcat_parser_t milkcat_parser_t;
 
 typedef struct milkcat_parseriter_internal_t milkcat_parseriter_internal_t;
@@ -16,12 +19,16 @@ typedef struct milkcat_parseriterator_t {
   int head;
   const char *dependency_label;
   bool is_begin_of_sentence;
+  int64_t begin_offset;
+  int64_t end_offset;
   milkcat_parseriter_internal_t *it;
 } milkcat_parseriterator_t;
 
 #define MC_SEGMENTER_BIGRAM 0
 #define MC_SEGMENTER_CRF 1
 #define MC_SEGMENTER_MIXED 2
+#define MC_SEGMENTER_MAXMATCH 3
+#define MC_SEGMENTER_BIMAXMATCH 4
 
 #define MC_POSTAGGER_MIXED 0
 #define MC_POSTAGGER_CRF 1
@@ -39,6 +46,7 @@ typedef struct milkcat_parseroptions_t {
   char *user_dictionary_path;
   char *model_path;
   bool use_gbk;
+  int postagger_beam_size;
 } milkcat_parseroptions_t;
 
 void milkcat_parseroptions_init(milkcat_parseroptions_t *parseropt);
@@ -0,0 +1,233 @@
+//
+// The MIT License (MIT)
+//
+// Copyright 2013-2014 The MilkCat Project Developers
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// crf_tagger_test.cc --- Created at 2015-03-16
+//
+
+#include "ml/crf_tagger.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "common/model.h"
+#include "ml/feature_set.h"
+#include "ml/sequence_feature_set.h"
+#include "util/status.h"
+
+using milkcat::CRFModel;
+using milkcat::CRFTagger;
+using milkcat::FeatureSet;
+using milkcat::SequenceFeatureSet;
+using milkcat::Status;
+
+// A text without sentence break, its characters are the features of CRF
+// segmenter model
+const char *kText = "博丽灵梦是与雾雨魔理沙并列的第一自机我的猫喜欢喝牛奶"
+                    "明天也是晴天";
+
+// The tags of segmenter model and their allowed transitions
+const int kTagNum = 6;
+const char *kTagName[kTagNum] = {"S", "B", "B1", "B2", "M", "E"};
+
+struct SegmenterTagset {
+  enum { kTagNum = 6 };
+  static const bool kTransition[kTagNum][kTagNum];
+};
+
+const bool SegmenterTagset::kTransition[6][6] = {
+  // S      B      B1     B2     M      E
+  {true,  true,  false, false, false, false},  // S
+  {false, false, true,  false, false, true },  // B
+  {false, false, false, true,  false, true },  // B1
+  {false, false, false, false, true,  true },  // B2
+  {false, false, false, false, true,  true },  // M
+  {true,  true,  false, false, false, false}   // E
+};
+
+// Puts the characters of a sequence into the tagger
+class CharacterExtractor: public CRFTagger::FeatureExtractor {
+ public:
+  explicit CharacterExtractor(const std::vector<std::string> &characters):
+      characters_(characters) {
+  }
+
+  void Extract(SequenceFeatureSet *sequence_feature_set,
+               CRFTagger::Lattice *lattice,
+               int begin,
+               int end) {
+    sequence_feature_set->set_size(end - begin);
+    for (int idx = begin; idx < end; ++idx) {
+      FeatureSet *feature_set = sequence_feature_set->at_index(idx - begin);
+      feature_set->Clear();
+      feature_set->Add(characters_[idx].c_str());
+      sequence_feature_set->set_id_at(idx - begin, -1);
+      lattice->AllowAll(idx - begin);
+    }
+  }
+
+ private:
+  const std::vector<std::string> &characters_;
+};
+
+// Gets `size` characters of kText repeated, from the `shift`-th character
+std::vector<std::string> make_characters(int size, int shift) {
+  std::vector<std::string> characters;
+  int text_length = strlen(kText);
+  while (static_cast<int>(characters.size()) < size + shift) {
+    for (int i = 0; i < text_length; i += 3) {
+      characters.push_back(std::string(kText + i, 3));
+    }
+  }
+  characters.erase(characters.begin(), characters.begin() + shift);
+  characters.resize(size);
+  return characters;
+}
+
+// Creates the tagger of segmenter model with its transitions, and gets the
+// tag ids into `tag_ids`
+CRFTagger *new_segmenter_tagger(milkcat::Model *model, int *tag_ids) {
+  Status status;
+  const CRFModel *crf_model = model->CRFSegModel(&status);
+  assert(status.ok());
+
+  CRFTagger *tagger = new CRFTagger(crf_model);
+  for (int i = 0; i < kTagNum; ++i) {
+    tag_ids[i] = tagger->yid(kTagName[i]);
+    assert(tag_ids[i] >= 0);
+  }
+
+  CRFTagger::TransitionTable *transition_table = tagger->transition_table();
+  transition_table->DisallowAll();
+  for (int left = 0; left < kTagNum; ++left) {
+    for (int right = 0; right < kTagNum; ++right) {
+      if (SegmenterTagset::kTransition[left][right])
+        transition_table->Allow(tag_ids[left], tag_ids[right]);
+    }
+  }
+  return tagger;
+}
+
+// Tags the whole `characters` in one pass and gets the tags
+std::vector<int> tag_characters(CRFTagger *tagger,
+                                const std::vector<std::string> &characters,
+                                int S) {
+  int size = characters.size();
+  CharacterExtractor extractor(characters);
+  SequenceFeatureSet sequence_feature_set;
+  extractor.Extract(&sequence_feature_set, tagger->lattice(), 0, size);
+  tagger->TagRange(&sequence_feature_set, 0, size, S, S);
+
+  std::vector<int> tags;
+  for (int i = 0; i < size; ++i) tags.push_back(tagger->y(i));
+  return tags;
+}
+
+// Decodes a sequence much longer than kWindowSize by TagRangeWindowed and
+// by TagRange in one pass. The sequence starts from the `shift`-th character
+// of kText, so the seams fall on different positions in words. The windowed
+// result should follow the transition table at the seams, and be the same
+// as the one-pass result except the positions near the seams
+void check_windowed_decoding(CRFTagger *tagger,
+                             const int *tag_ids,
+                             int shift) {
+  std::vector<std::string> characters = make_characters(
+      3 * CRFTagger::kWindowSize + 100,
+      shift);
+  int size = characters.size();
+  CharacterExtractor extractor(characters);
+
+  int S = tag_ids[0];
+  tagger->TagRangeWindowed(&extractor, size, 0, size, S, S);
+  std::vector<int> windowed_tags;
+  for (int i = 0; i < size; ++i) windowed_tags.push_back(tagger->y(i));
+
+  std::vector<int> tags = tag_characters(tagger, characters, S);
+  for (int i = 0; i < size; ++i) {
+    if (i > 0) {
+      assert(tagger->transition_table()->transition(windowed_tags[i - 1],
+                                                    windowed_tags[i]));
+    }
+
+    int seam_distance = i % CRFTagger::kWindowSize;
+    seam_distance = std::min(seam_distance,
+                             CRFTagger::kWindowSize - seam_distance);
+    if (seam_distance >= CRFTagger::kWindowOverlap) {
+      assert(windowed_tags[i] == tags[i]);
+    }
+  }
+}
+
+int windowed_decoding_test() {
+  milkcat::Model model(MODEL_DIR);
+  int tag_ids[kTagNum];
+  CRFTagger *tagger = new_segmenter_tagger(&model, tag_ids);
+
+  // The general Viterbi decoder and the fixed-tagset decoder
+  const int kShifts = 16;
+  for (int shift = 0; shift < kShifts; ++shift) {
+    check_windowed_decoding(tagger, tag_ids, shift);
+  }
+  if (tagger->ysize() == kTagNum) {
+    tagger->UseFixedDecoder<SegmenterTagset>(tag_ids);
+    for (int shift = 0; shift < kShifts; ++shift) {
+      check_windowed_decoding(tagger, tag_ids, shift);
+    }
+  }
+
+  delete tagger;
+  return 0;
+}
+
+// The buffers grown by a long sequence and released by Trim() should not
+// change the results
+int trim_test() {
+  milkcat::Model model(MODEL_DIR);
+  int tag_ids[kTagNum];
+  CRFTagger *tagger = new_segmenter_tagger(&model, tag_ids);
+  tagger->set_compute_marginals(true);
+
+  int S = tag_ids[0];
+  std::vector<std::string> long_characters = make_characters(5000, 0);
+  std::vector<std::string> short_characters = make_characters(20, 3);
+
+  std::vector<int> short_tags = tag_characters(tagger, short_characters, S);
+  std::vector<int> long_tags = tag_characters(tagger, long_characters, S);
+  assert(tag_characters(tagger, short_characters, S) == short_tags);
+
+  tagger->Trim();
+  assert(tag_characters(tagger, short_characters, S) == short_tags);
+  tagger->Trim();
+  assert(tag_characters(tagger, long_characters, S) == long_tags);
+  assert(tag_characters(tagger, short_characters, S) == short_tags);
+
+  delete tagger;
+  return 0;
+}
+
+int main() {
+  windowed_decoding_test();
+  trim_test();
+  return 0;
+}
@@ -25,10 +25,22 @@
 //
 
 #include <assert.h>
+#include <limits.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
 #include "include/milkcat.h"
 #include "libmilkcat.h"
+#include "common/model.h"
+#include "common/reimu_trie.h"
+#include "common/static_array.h"
+#include "segmenter/mixed_segmenter.h"
+#include "tagger/crf_part_of_speech_tagger.h"
+#include "tagger/hmm_part_of_speech_tagger.h"
+#include "tokenizer/tokenizer.h"
 #include "util/encoding.h"
 
 using milkcat::Parser;
@@ -58,10 +70,50 @@ const char bigram_test_word[][64] = {
    "博丽灵梦", "是", "与", "雾雨魔理沙", "并列", "的", "第一", "自", "机"
 };
 
+// Reads a string in chunks of 1 to 3 bytes, so the characters are cut
+class StringReader: public Parser::Reader {
+ public:
+  explicit StringReader(const char *text): text_(text), chunk_size_(0) {}
+
+  int Read(char *buffer, int size) {
+    chunk_size_ = chunk_size_ % 3 + 1;
+    int read_size = std::min(std::min(chunk_size_, size),
+                             static_cast<int>(strlen(text_)));
+    memcpy(buffer, text_, read_size);
+    text_ += read_size;
+    return read_size;
+  }
+
+ private:
+  const char *text_;
+  int chunk_size_;
+};
+
+// Reads the text in chunks as large as required
+class BlockReader: public Parser::Reader {
+ public:
+  explicit BlockReader(const std::string &text): text_(text), position_(0) {}
+
+  int Read(char *buffer, int size) {
+    int read_size = std::min(size,
+                             static_cast<int>(text_.size()) - position_);
+    memcpy(buffer, text_.data() + position_, read_size);
+    position_ += read_size;
+    return read_size;
+  }
+
+ private:
+  const std::string &text_;
+  int position_;
+};
+
 void check_prediction(Parser::Iterator *parseriter, bool use_gbk) {
   milkcat::Encoding *encoding = new milkcat::Encoding();
   char gbk_word[256];
 
+  // The words cover the whole input text, so each word begins where the
+  // previous one ends
+  int64_t offset = 0;
   for (int i = 0; i < kLength; ++i) {
     assert(parseriter->Next());
     assert(parseriter->is_begin_of_sentence() == isbos[i]);
@@ -77,6 +129,11 @@ void check_prediction(Parser::Iterator *parseriter, bool use_gbk) {
     assert(strcmp(parseriter->part_of_speech_tag(), postag[i]) == 0);
     assert(strcmp(parseriter->dependency_label(), label[i]) == 0);
     assert(parseriter->head() == head[i]);
+
+    assert(parseriter->begin_offset() == offset);
+    offset = parseriter->end_offset();
+    assert(offset - parseriter->begin_offset() ==
+           static_cast<int64_t>(strlen(parseriter->word())));
   }
   assert(parseriter->Next() == false);
 
@@ -95,6 +152,27 @@ int parser_test() {
   Parser::Iterator *parseriter = new Parser::Iterator();
   parser->Predict(parseriter, kSentence);
   check_prediction(parseriter, false);
+
+  // Parses the text in place, it needs not end with NUL
+  std::string buffer = std::string(kSentence) + "猫喜欢";
+  parser->Predict(parseriter, buffer.data(), strlen(kSentence));
+  check_prediction(parseriter, false);
+
+  // The text longer than 2GB is rejected before it is read
+  size_t huge_length = static_cast<size_t>(INT_MAX) + 1;
+  parser->Predict(parseriter, buffer.data(), huge_length);
+  assert(parseriter->Next() == false);
+  assert(strstr(milkcat::LastError(), "PredictStream") != NULL);
+
+  // Parses the text from a stream
+  StringReader reader(kSentence);
+  parser->PredictStream(parseriter, &reader);
+  check_prediction(parseriter, false);
+
+  // The buffers released by Trim() grow again
+  parser->Trim();
+  parser->Predict(parseriter, kSentence);
+  check_prediction(parseriter, false);
   delete parser;
 
   // Testes yamada parser
@@ -194,6 +272,315 @@ int bigram_segmenter_test() {
   return 0; 
 }
 
+// The bytes of invalid UTF-8 skipped by the tokenizer are not in the word
+// joined across them, but its offsets cover them
+int invalid_utf8_test() {
+  FILE *fd = fopen("user.txt", "w");
+  assert(fd);
+  fputs("我的猫 100.0\n", fd);
+  fclose(fd);
+
+  void (Parser::Options::*use_segmenter[])() = {
+    &Parser::Options::UseBigramSegmenter,
+    &Parser::Options::UseMaxMatchSegmenter,
+    &Parser::Options::UseMixedSegmenter
+  };
+  for (int i = 0; i < 3; ++i) {
+    Parser::Options options;
+    options.SetUserDictionary("user.txt");
+    (options.*use_segmenter[i])();
+    options.NoPOSTagger();
+    options.SetModelPath(MODEL_DIR);
+    Parser *parser = new Parser(options);
+    assert(parser->ok());
+
+    Parser::Iterator parseriter;
+    parser->Predict(&parseriter, "我\x80的猫喜欢喝牛奶");
+    assert(parseriter.Next());
+    assert(strcmp(parseriter.word(), "我的猫") == 0);
+    assert(parseriter.begin_offset() == 0);
+    assert(parseriter.end_offset() == 10);
+    while (parseriter.Next()) {
+      assert(strchr(parseriter.word(), '\x80') == NULL);
+    }
+    delete parser;
+  }
+
+  return 0;
+}
+
+int max_match_segmenter_test() {
+  const char *text = "博丽灵梦是与雾雨魔理沙并列的第一自机";
+  FILE *fd = fopen("user.txt", "w");
+  assert(fd);
+  fputs("博丽灵梦\n", fd);
+  fputs("雾雨魔理沙\n", fd);
+  fclose(fd);
+
+  Parser::Options options;
+  options.SetUserDictionary("user.txt");
+  options.NoPOSTagger();
+  options.SetModelPath(MODEL_DIR);
+  for (int bidirectional = 0; bidirectional < 2; ++bidirectional) {
+    if (bidirectional) {
+      options.UseBiMaxMatchSegmenter();
+    } else {
+      options.UseMaxMatchSegmenter();
+    }
+    Parser *parser = new Parser(options);
+    assert(parser->ok());
+    Parser::Iterator parseriter;
+    parser->Predict(&parseriter, text);
+
+    // The words cover the whole text and the user words are matched
+    std::string joined;
+    int user_words = 0;
+    while (parseriter.Next()) {
+      joined += parseriter.word();
+      if (strcmp(parseriter.word(), "博丽灵梦") == 0 ||
+          strcmp(parseriter.word(), "雾雨魔理沙") == 0) {
+        ++user_words;
+      }
+    }
+    assert(joined == text);
+    assert(user_words == 2);
+
+    delete parser;
+  }
+
+  return 0;
+}
+
+int segmentation_nbest_test() {
+  const char *text = "我的猫喜欢喝牛奶";
+
+  Parser::Options options;
+  options.UseBigramSegmenter();
+  options.NoPOSTagger();
+  options.SetSegmentationNBest(5);
+  options.SetModelPath(MODEL_DIR);
+  Parser *parser = new Parser(options);
+  assert(parser->ok());
+  Parser::Iterator parseriter;
+  parser->Predict(&parseriter, text);
+
+  std::vector<std::string> best;
+  int alternative_number = 0;
+  while (parseriter.Next()) {
+    if (parseriter.is_begin_of_sentence()) {
+      alternative_number = parseriter.alternative_number();
+      assert(alternative_number > 0 && alternative_number <= 5);
+      for (int i = 1; i < alternative_number; ++i) {
+        assert(parseriter.alternative_cost(i - 1) <=
+               parseriter.alternative_cost(i));
+      }
+    }
+    best.push_back(parseriter.word());
+  }
+
+  // The first alternative has the best cost, which is the result of the
+  // bigram segmenter. Every alternative covers the whole text, and no two
+  // alternatives are the same segmentation
+  Parser::Iterator nbest_iter;
+  parser->Predict(&nbest_iter, text);
+  assert(nbest_iter.Next());
+  assert(nbest_iter.alternative_size(0) == static_cast<int>(best.size()));
+  for (int j = 0; j < nbest_iter.alternative_size(0); ++j) {
+    assert(best[j] == nbest_iter.alternative_word(0, j));
+  }
+
+  std::vector<std::vector<std::string> > alternatives;
+  for (int i = 0; i < alternative_number; ++i) {
+    std::vector<std::string> words;
+    std::string joined;
+    for (int j = 0; j < nbest_iter.alternative_size(i); ++j) {
+      words.push_back(nbest_iter.alternative_word(i, j));
+      joined += words.back();
+    }
+    assert(joined == text);
+
+    for (int k = 0; k < i; ++k) assert(alternatives[k] != words);
+    alternatives.push_back(words);
+  }
+
+  delete parser;
+  return 0;
+}
+
+// Gets the words, tags and heads of `text` in one string
+std::string parse_result(Parser *parser, const char *text) {
+  Parser::Iterator parseriter;
+  parser->Predict(&parseriter, text);
+
+  std::string result;
+  char head[16];
+  while (parseriter.Next()) {
+    sprintf(head, "%d", parseriter.head());
+    result += parseriter.word();
+    result += "/";
+    result += parseriter.part_of_speech_tag();
+    result += "/";
+    result += head;
+    result += parseriter.dependency_label();
+    result += " ";
+  }
+  return result;
+}
+
+// Parses the text repeatedly in a thread, and checks the results
+struct CacheThreadData {
+  Parser *parser;
+  const char *text;
+  const std::string *expected;
+  bool ok;
+};
+
+void *parse_in_thread(void *arg) {
+  CacheThreadData *data = static_cast<CacheThreadData *>(arg);
+  data->ok = true;
+  for (int i = 0; i < 50; ++i) {
+    if (parse_result(data->parser, data->text) != *data->expected) {
+      data->ok = false;
+    }
+  }
+  return NULL;
+}
+
+int sentence_cache_test() {
+  // The text has 5 sentences: the 2 of kSentence, the line break and the 2
+  // of kSentence again
+  std::string text = kSentence;
+  text += "\n";
+  text += kSentence;
+
+  Parser::Options options;
+  options.UseBeamYamadaParser();
+  options.SetModelPath(MODEL_DIR);
+  Parser *parser = new Parser(options);
+  assert(parser->ok());
+  std::string expected = parse_result(parser, text.c_str());
+  std::string sentence_expected = parse_result(parser, kSentence);
+  assert(parser->sentence_cache_hits() == 0);
+  assert(parser->sentence_cache_misses() == 0);
+  delete parser;
+
+  // The last 2 sentences are found in cache, and the results are the same
+  options.EnableSentenceCache(16);
+  parser = new Parser(options);
+  assert(parser->ok());
+  assert(parse_result(parser, text.c_str()) == expected);
+  assert(parser->sentence_cache_hits() == 2);
+  assert(parser->sentence_cache_misses() == 3);
+  assert(parse_result(parser, text.c_str()) == expected);
+  assert(parser->sentence_cache_hits() == 7);
+  assert(parser->sentence_cache_misses() == 3);
+  delete parser;
+
+  // The cache is shared by parsers from the pool, only the first parse of
+  // kSentence misses
+  milkcat::ParserPool parser_pool(options);
+  assert(parser_pool.ok());
+  Parser *parser1 = parser_pool.NewParser();
+  Parser *parser2 = parser_pool.NewParser();
+  assert(parse_result(parser1, kSentence) == sentence_expected);
+  assert(parse_result(parser2, kSentence) == sentence_expected);
+  assert(parse_result(parser1, kSentence) == sentence_expected);
+  assert(parser_pool.sentence_cache_hits() == 4);
+  assert(parser_pool.sentence_cache_misses() == 2);
+  assert(parser1->sentence_cache_hits() == 4);
+  parser_pool.ReleaseAll();
+
+  // Two threads parse the same text with the shared cache at the same time.
+  // A sentence could be missed by both threads before it is cached
+  milkcat::ParserPool thread_pool(options);
+  assert(thread_pool.ok());
+  CacheThreadData data[2];
+  pthread_t threads[2];
+  for (int i = 0; i < 2; ++i) {
+    data[i].parser = thread_pool.NewParser();
+    data[i].text = text.c_str();
+    data[i].expected = &expected;
+    assert(data[i].parser);
+  }
+  for (int i = 0; i < 2; ++i) {
+    assert(pthread_create(&threads[i], NULL, parse_in_thread, &data[i]) == 0);
+  }
+  for (int i = 0; i < 2; ++i) {
+    assert(pthread_join(threads[i], NULL) == 0);
+    assert(data[i].ok);
+  }
+  int64_t misses = thread_pool.sentence_cache_misses();
+  assert(misses >= 3 && misses <= 6);
+  assert(thread_pool.sentence_cache_hits() + misses == 2 * 50 * 5);
+  thread_pool.ReleaseAll();
+
+  return 0;
+}
+
+// Segments `text` with only the segmenter selected by `use_segmenter`
+std::string segment_result(void (Parser::Options::*use_segmenter)(),
+                           const char *text) {
+  Parser::Options options;
+  (options.*use_segmenter)();
+  options.NoPOSTagger();
+  options.SetModelPath(MODEL_DIR);
+  Parser *parser = new Parser(options);
+  assert(parser->ok());
+  std::string result = parse_result(parser, text);
+  delete parser;
+  return result;
+}
+
+// The mixed segmenter keeps the bigram result for the sentences without two
+// adjacent terms to recognize, and the CRF segmenter recognizes the span of
+// unknown characters. Each sentence is counted on its path
+int mixed_segmenter_counter_test() {
+  const char *kBigramOnly = "hello world.";
+  const char *kOOVSpan = "龘靐齉";
+
+  Parser::Options options;
+  options.UseMixedSegmenter();
+  options.NoPOSTagger();
+  options.SetModelPath(MODEL_DIR);
+  Parser *parser = new Parser(options);
+  assert(parser->ok());
+  assert(parser->oov_recognized_number() == 0);
+  assert(parser->bigram_only_number() == 0);
+
+  assert(parse_result(parser, kBigramOnly) ==
+         segment_result(&Parser::Options::UseBigramSegmenter, kBigramOnly));
+  assert(parser->oov_recognized_number() == 0);
+  assert(parser->bigram_only_number() == 1);
+
+  assert(parse_result(parser, kOOVSpan) ==
+         segment_result(&Parser::Options::UseCRFSegmenter, kOOVSpan));
+  assert(parser->oov_recognized_number() == 1);
+  assert(parser->bigram_only_number() == 1);
+
+  // Each of the two sentences takes one of the paths
+  parse_result(parser, kSentence);
+  assert(parser->oov_recognized_number() +
+         parser->bigram_only_number() == 4);
+
+  milkcat::MixedSegmenter *segmenter = static_cast<milkcat::MixedSegmenter *>(
+      parser->impl()->segmenter());
+  assert(segmenter->oov_recognized_number() ==
+         parser->oov_recognized_number());
+  assert(segmenter->bigram_only_number() == parser->bigram_only_number());
+  delete parser;
+
+  // Other segmenters have no such counters
+  options.UseBigramSegmenter();
+  parser = new Parser(options);
+  assert(parser->ok());
+  parse_result(parser, kSentence);
+  assert(parser->oov_recognized_number() == 0);
+  assert(parser->bigram_only_number() == 0);
+  delete parser;
+
+  return 0;
+}
+
 int gbk_test() {
   Parser::Options options;
   options.UseMixedSegmenter();
@@ -212,17 +599,247 @@ int gbk_test() {
   Parser::Iterator *parseriter = new Parser::Iterator();
   parser->Predict(parseriter, gbk_sentence);
   check_prediction(parseriter, true);
+  parser->Predict(parseriter, gbk_sentence, strlen(gbk_sentence));
+  check_prediction(parseriter, true);
+
+  // The GBK text is converted into UTF-8 of at most twice its size, so the
+  // text longer than 1GB is rejected before it is read
+  size_t huge_length = static_cast<size_t>((INT_MAX - 1) / 2) + 1;
+  parser->Predict(parseriter, gbk_sentence, huge_length);
+  assert(parseriter->Next() == false);
+  assert(strstr(milkcat::LastError(), "PredictStream") != NULL);
+
+  StringReader reader(gbk_sentence);
+  parser->PredictStream(parseriter, &reader);
+  check_prediction(parseriter, true);
   delete parser;
 
   delete parseriter;
   return 0;
 }
 
+// A GBK stream without sentence break and longer than the buffer of
+// tokenizer is split into sentences, no text is lost between them
+int gbk_stream_test() {
+  Parser::Options options;
+  options.UseBigramSegmenter();
+  options.NoPOSTagger();
+  options.UseGBK();
+  options.SetModelPath(MODEL_DIR);
+
+  char gbk_sentence[2048];
+  milkcat::Encoding *encoding = new milkcat::Encoding();
+  encoding->UTF8ToGBK("我的猫喜欢喝牛奶", gbk_sentence, sizeof(gbk_sentence));
+  delete encoding;
+
+  std::string gbk_text;
+  while (gbk_text.size() <= milkcat::Tokenizer::kStreamBufferSize) {
+    gbk_text += gbk_sentence;
+  }
+
+  Parser *parser = new Parser(options);
+  assert(parser->ok());
+  Parser::Iterator parseriter;
+  BlockReader reader(gbk_text);
+  parser->PredictStream(&parseriter, &reader);
+
+  std::string result;
+  int sentence_number = 0;
+  while (parseriter.Next()) {
+    if (parseriter.is_begin_of_sentence()) sentence_number++;
+    assert(parseriter.begin_offset() == static_cast<int64_t>(result.size()));
+    result += parseriter.word();
+    assert(parseriter.end_offset() == static_cast<int64_t>(result.size()));
+  }
+  assert(sentence_number > 1);
+  assert(result == gbk_text);
+
+  delete parser;
+  return 0;
+}
+
+// Gets the words of `parseriter` and checks their offsets in `text`
+std::string check_offsets(Parser::Iterator *parseriter,
+                          const std::string &text) {
+  std::string result;
+  int64_t offset = 0;
+  while (parseriter->Next()) {
+    const char *word = parseriter->word();
+    int64_t length = static_cast<int64_t>(strlen(word));
+    assert(parseriter->begin_offset() >= offset);
+    assert(parseriter->end_offset() - parseriter->begin_offset() == length);
+    assert(text.compare(parseriter->begin_offset(), length, word) == 0);
+    offset = parseriter->end_offset();
+    result += word;
+  }
+  return result;
+}
+
+// The bytes which are not valid GBK are skipped, but the text after them is
+// kept and the offsets of words are still in the input text
+int gbk_invalid_byte_test() {
+  Parser::Options options;
+  options.UseBigramSegmenter();
+  options.NoPOSTagger();
+  options.UseGBK();
+  options.SetModelPath(MODEL_DIR);
+
+  char gbk_sentence[2048];
+  milkcat::Encoding *encoding = new milkcat::Encoding();
+  encoding->UTF8ToGBK(kSentence, gbk_sentence, sizeof(gbk_sentence));
+  delete encoding;
+
+  // 0xff is never in GBK, and 0x81 here is a lead byte without trail byte
+  std::string expected = gbk_sentence;
+  expected += " abc";
+  std::string gbk_text = gbk_sentence;
+  gbk_text.insert(4, "\xff");
+  gbk_text += "\x81 abc\xff";
+
+  Parser *parser = new Parser(options);
+  assert(parser->ok());
+  Parser::Iterator parseriter;
+  parser->Predict(&parseriter, gbk_text.c_str());
+  assert(check_offsets(&parseriter, gbk_text) == expected);
+  parser->Predict(&parseriter, gbk_text.data(), gbk_text.size());
+  assert(check_offsets(&parseriter, gbk_text) == expected);
+  StringReader reader(gbk_text.c_str());
+  parser->PredictStream(&parseriter, &reader);
+  assert(check_offsets(&parseriter, gbk_text) == expected);
+  BlockReader block_reader(gbk_text);
+  parser->PredictStream(&parseriter, &block_reader);
+  assert(check_offsets(&parseriter, gbk_text) == expected);
+
+  delete parser;
+  return 0;
+}
+
+int confidence_test() {
+  Parser::Options options;
+  options.UseCRFSegmenter();
+  options.UseCRFPOSTagger();
+  options.SetModelPath(MODEL_DIR);
+  Parser *parser = new Parser(options);
+  assert(parser->ok());
+
+  options.EnableConfidence();
+  Parser *confidence_parser = new Parser(options);
+  assert(confidence_parser->ok());
+
+  // Computing the confidence should not change the result
+  Parser::Iterator parseriter, confidence_parseriter;
+  parser->Predict(&parseriter, kSentence);
+  confidence_parser->Predict(&confidence_parseriter, kSentence);
+  while (parseriter.Next()) {
+    assert(confidence_parseriter.Next());
+    assert(strcmp(parseriter.word(), confidence_parseriter.word()) == 0);
+    assert(strcmp(parseriter.part_of_speech_tag(),
+                  confidence_parseriter.part_of_speech_tag()) == 0);
+    assert(parseriter.confidence() == 1.0);
+
+    double confidence = confidence_parseriter.confidence();
+    assert(confidence > 0.0 && confidence <= 1.0 + 1e-6);
+    assert(confidence >= confidence_parseriter.sentence_confidence());
+  }
+  assert(confidence_parseriter.Next() == false);
+
+  delete parser;
+  delete confidence_parser;
+  return 0;
+}
+
+// The beam size of part-of-speech tagger is passed to the CRF tagger and
+// the HMM tagger, 0 keeps the default beam of HMM tagger
+int postagger_beam_size_test() {
+  Parser::Options options;
+  options.UseBigramSegmenter();
+  options.UseHMMPOSTagger();
+  options.SetModelPath(MODEL_DIR);
+
+  Parser *parser = new Parser(options);
+  assert(parser->ok());
+  milkcat::HMMPartOfSpeechTagger *hmm_tagger =
+      static_cast<milkcat::HMMPartOfSpeechTagger *>(
+          parser->impl()->part_of_speech_tagger());
+  assert(hmm_tagger->beam_size() ==
+         milkcat::HMMPartOfSpeechTagger::kBeamSize);
+  delete parser;
+
+  options.SetPOSTaggerBeamSize(8);
+  parser = new Parser(options);
+  assert(parser->ok());
+  hmm_tagger = static_cast<milkcat::HMMPartOfSpeechTagger *>(
+      parser->impl()->part_of_speech_tagger());
+  assert(hmm_tagger->beam_size() == 8);
+  delete parser;
+
+  options.UseCRFPOSTagger();
+  parser = new Parser(options);
+  assert(parser->ok());
+  milkcat::CRFPartOfSpeechTagger *crf_tagger =
+      static_cast<milkcat::CRFPartOfSpeechTagger *>(
+          parser->impl()->part_of_speech_tagger());
+  assert(crf_tagger->crf_tagger()->beam_size() == 8);
+  delete parser;
+
+  return 0;
+}
+
+// The merged out-of-vocabulary property file keeps the table built from the
+// property trie, and it is refused with another unigram index
+int oov_property_file_test() {
+  milkcat::Model model(MODEL_DIR);
+  milkcat::Status status;
+  const milkcat::ReimuTrie *index = model.Index(&status);
+  const milkcat::ReimuTrie *oov_property = NULL;
+  if (status.ok()) oov_property = model.OOVProperty(&status);
+  assert(status.ok());
+
+  milkcat::StaticArray<uint8_t> *table =
+      milkcat::Model::BuildOOVPropertyByTermId(index, oov_property, NULL);
+  milkcat::Model::SaveOOVPropertyByTermId("oov_property.bin",
+                                          table,
+                                          index,
+                                          &status);
+  assert(status.ok());
+
+  milkcat::StaticArray<uint8_t> *merged =
+      milkcat::Model::ReadOOVPropertyByTermId("oov_property.bin",
+                                              index,
+                                              &status);
+  assert(status.ok());
+  assert(merged->size() == table->size());
+  for (int i = 0; i < table->size(); ++i) {
+    assert(merged->get(i) == table->get(i));
+  }
+  delete merged;
+
+  merged = milkcat::Model::ReadOOVPropertyByTermId("oov_property.bin",
+                                                   oov_property,
+                                                   &status);
+  assert(!status.ok());
+  assert(merged == NULL);
+
+  delete table;
+  remove("oov_property.bin");
+  return 0;
+}
+
 int main() {
   parser_test();
+  confidence_test();
   empty_string_test();
   bigram_segmenter_test();
+  max_match_segmenter_test();
+  invalid_utf8_test();
+  segmentation_nbest_test();
+  sentence_cache_test();
+  mixed_segmenter_counter_test();
+  postagger_beam_size_test();
+  oov_property_file_test();
   gbk_test();
+  gbk_stream_test();
+  gbk_invalid_byte_test();
   parserpool_test();
 
   return 0;
@@ -43,10 +43,14 @@ void check_result(milkcat_parseriterator_t *it,
                   char (*word)[TOKEN_MAX],
                   char (*postag)[TOKEN_MAX],
                   int length) {
+  int64_t offset = 0;
   for (int i = 0; i < length; ++i) {
     assert(milkcat_parseriterator_next(it));
     assert(strcmp(it->word, word[i]) == 0);
     assert(strcmp(it->part_of_speech_tag, postag[i]) == 0);
+    assert(it->begin_offset == offset);
+    assert(it->end_offset - it->begin_offset == (int64_t)strlen(word[i]));
+    offset = it->end_offset;
   }
   assert(!milkcat_parseriterator_next(it));
   assert(!milkcat_parseriterator_next(it));
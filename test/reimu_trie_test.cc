@@ -276,12 +276,36 @@ void traverse_test() {
   puts("traverse_test OK");
 }
 
+void next_pair_test() {
+  ReimuTrie *trie = new ReimuTrie();
+  for (int i = 0; i < HALF_N; ++i) {
+    trie->Put(putset[i].c_str(), i);
+  }
+
+  std::vector<bool> found(HALF_N, false);
+  std::string key;
+  ReimuTrie::int32 value;
+  int position = 0, count = 0;
+  while (trie->NextPair(&position, &key, &value)) {
+    assert(value >= 0 && value < HALF_N);
+    assert(key == putset[value]);
+    assert(found[value] == false);
+    found[value] = true;
+    count++;
+  }
+  assert(count == HALF_N);
+
+  delete trie;
+  puts("next_pair_test OK");
+}
+
 int main() {
   generate_test_data();
   simple_get_put_test();
   save_and_open_test();
   restore_test();
   traverse_test();
+  next_pair_test();
   // set_array_test();
 
 #ifdef BENCHMARK
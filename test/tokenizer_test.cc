@@ -0,0 +1,237 @@
+//
+// The MIT License (MIT)
+//
+// Copyright 2013-2014 The MilkCat Project Developers
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// tokenizer_test.cc --- Created at 2015-03-22
+//
+
+#include "tokenizer/tokenizer.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "include/milkcat.h"
+#include "tokenizer/token_instance.h"
+#include "tokenizer_test_golden.h"
+
+using milkcat::Tokenizer;
+using milkcat::TokenInstance;
+
+struct ExpectedToken {
+  const char *text;
+  int type;
+};
+
+// The tokens given by the former flex scanner, NULL ends a sentence
+const ExpectedToken kExpected[] = {
+  {"我", TokenInstance::kChineseChar},
+  {"爱", TokenInstance::kChineseChar},
+  {"北", TokenInstance::kChineseChar},
+  {"京", TokenInstance::kChineseChar},
+  {"。", TokenInstance::kPeriod},
+  {NULL, 0},
+  {"MilkCat", TokenInstance::kEnglishWord},
+  {" ", TokenInstance::kSpace},
+  {"1.5", TokenInstance::kNumber},
+  {"  ", TokenInstance::kSpace},
+  {"版", TokenInstance::kChineseChar},
+  {",", TokenInstance::kPunctuation},
+  {"3.14.15", TokenInstance::kSymbol},
+  {"\t", TokenInstance::kSpace},
+  {"2.", TokenInstance::kSymbol},
+  {"，", TokenInstance::kPunctuation},
+  {"!", TokenInstance::kPunctuation},
+  {"，", TokenInstance::kPunctuation},
+  {"a-b", TokenInstance::kSymbol},
+  {"？", TokenInstance::kPeriod},
+  {NULL, 0},
+  {"ＡＢＣ", TokenInstance::kEnglishWord},
+  {" ", TokenInstance::kSpace},
+  {"１２", TokenInstance::kNumber},
+  {"．", TokenInstance::kOther},
+  {"３", TokenInstance::kNumber},
+  {" ", TokenInstance::kSpace},
+  {"ＷＸＹ", TokenInstance::kEnglishWord},
+  {"Ｗ", TokenInstance::kOther},
+  {"\r\n\n", TokenInstance::kCrLf},
+  {NULL, 0},
+  {"“", TokenInstance::kPunctuation},
+  {"你", TokenInstance::kChineseChar},
+  {"”", TokenInstance::kPunctuation},
+  {"·", TokenInstance::kPunctuation},
+  {"中", TokenInstance::kChineseChar},
+  {NULL, 0}
+};
+
+int fixed_text_test() {
+  // "\xff" is not valid UTF-8 and skipped
+  const char *text = "我爱北京。MilkCat 1.5  版,3.14.15\t2.，!，a-b？"
+                     "ＡＢＣ １２．３ ＷＸＹＷ\r\n\n“你”·\xff中";
+  Tokenizer tokenizer;
+  TokenInstance token_instance;
+  tokenizer.Scan(text, static_cast<int>(strlen(text)));
+
+  int expected_size = sizeof(kExpected) / sizeof(kExpected[0]);
+  int idx = 0;
+  while (tokenizer.GetSentence(&token_instance)) {
+    for (int i = 0; i < token_instance.size(); ++i) {
+      const char *token = token_instance.token_text_at(i);
+      assert(idx < expected_size && kExpected[idx].text != NULL);
+      assert(strcmp(token, kExpected[idx].text) == 0);
+      assert(token_instance.token_type_at(i) == kExpected[idx].type);
+      assert(strncmp(text + token_instance.token_offset_at(i),
+                     token,
+                     token_instance.token_length_at(i)) == 0);
+      idx++;
+    }
+    assert(kExpected[idx].text == NULL);
+    idx++;
+  }
+  assert(idx == expected_size);
+
+  // Scans the first 4 bytes in place, the partial "爱" is skipped
+  tokenizer.ScanInPlace(text, 4);
+  assert(tokenizer.GetSentence(&token_instance));
+  assert(token_instance.size() == 1);
+  assert(strcmp(token_instance.token_text_at(0), "我") == 0);
+  assert(tokenizer.GetSentence(&token_instance) == false);
+
+  return 0;
+}
+
+// The pieces of generated text: ASCII, fullwidth forms with "ＷＸ", CJK and
+// other characters, and the invalid or truncated UTF-8 sequences
+const char *kPieces[] = {
+  "a", "Z", "7", "0", ".", "!", "?", ",", " ", "\t", "\r", "\n", "-", "_",
+  "'", "@", "Ａ", "ｚ", "０", "９", "．", "！", "？", "，", "Ｗ", "Ｘ", "ＷＸ",
+  "\xe3\x80\x80", "。", "“", "”", "·", "中", "国", "龥", "é", "€",
+  "\xf0\x9f\x98\x80", "、", "：", "\x80", "\xc0", "\xff", "\xe4\xb8",
+  "\xc2", "\xf0\x9f", "\xef\xbc", "\xed\xa0\x80", "\xe0\x80\x80",
+  "\xf5\x80\x80\x80"
+};
+
+// Generates the text of `piece_number` pieces by a linear congruential
+// generator from `seed`. The runs of 1 to 40 letters and digits cross the
+// 16-byte blocks of the SSE2 scanner
+std::string generate_text(uint32_t seed, int piece_number) {
+  const char *kAlnum = "aB3xY9";
+  const int kPieceNumber = sizeof(kPieces) / sizeof(kPieces[0]);
+  std::string text;
+  for (int i = 0; i < piece_number; ++i) {
+    seed = seed * 1103515245u + 12345u;
+    uint32_t r = seed >> 8;
+    if (r % 4 == 0) {
+      int run = 1 + (r / 4) % 40;
+      for (int j = 0; j < run; ++j) text += kAlnum[(r / 160 + j * 7) % 6];
+      if (r / 160 % 5 == 0) text += ".";
+    } else {
+      int repeat = 1 + (r / 4) % 3;
+      for (int j = 0; j < repeat; ++j) {
+        text += kPieces[(r / 12) % kPieceNumber];
+      }
+    }
+  }
+  return text;
+}
+
+// Scans the text and gets the tokens as GoldenToken
+std::vector<GoldenToken> scan_tokens(Tokenizer *tokenizer) {
+  std::vector<GoldenToken> tokens;
+  TokenInstance token_instance;
+  while (tokenizer->GetSentence(&token_instance)) {
+    for (int i = 0; i < token_instance.size(); ++i) {
+      GoldenToken token = {
+        token_instance.token_type_at(i),
+        static_cast<int>(token_instance.text_offset() +
+                         token_instance.token_offset_at(i)),
+        token_instance.token_length_at(i)
+      };
+      tokens.push_back(token);
+    }
+    GoldenToken sentence_end = {0, 0, 0};
+    tokens.push_back(sentence_end);
+  }
+  return tokens;
+}
+
+bool operator==(const GoldenToken &left, const GoldenToken &right) {
+  return left.type == right.type &&
+         left.offset == right.offset &&
+         left.length == right.length;
+}
+
+// Reads the text by chunks of 1 to 7 bytes
+class ChunkReader: public milkcat::Parser::Reader {
+ public:
+  explicit ChunkReader(const std::string &text):
+      text_(text),
+      position_(0) {
+  }
+
+  int Read(char *buffer, int size) {
+    int read_size = std::min(1 + position_ % 7, size);
+    read_size = std::min(read_size,
+                         static_cast<int>(text_.size()) - position_);
+    memcpy(buffer, text_.data() + position_, read_size);
+    position_ += read_size;
+    return read_size;
+  }
+
+ private:
+  const std::string &text_;
+  int position_;
+};
+
+// The tokens of generated text are the same as the former flex scanner. The
+// text is scanned from each of 16 alignments and from a stream
+int golden_test() {
+  std::string text = generate_text(kGoldenSeed, kGoldenPieceNumber);
+  std::vector<GoldenToken> expected(
+      kGoldenTokens,
+      kGoldenTokens + sizeof(kGoldenTokens) / sizeof(kGoldenTokens[0]));
+
+  Tokenizer tokenizer;
+  std::vector<char> buffer(text.size() + 16);
+  for (int alignment = 0; alignment < 16; ++alignment) {
+    std::copy(text.begin(), text.end(), buffer.begin() + alignment);
+    tokenizer.ScanInPlace(buffer.data() + alignment,
+                          static_cast<int>(text.size()));
+    assert(scan_tokens(&tokenizer) == expected);
+  }
+
+  ChunkReader reader(text);
+  tokenizer.ScanStream(&reader);
+  assert(scan_tokens(&tokenizer) == expected);
+
+  return 0;
+}
+
+int main() {
+  fixed_text_test();
+  golden_test();
+
+  printf("tokenizer OK\n");
+  return 0;
+}
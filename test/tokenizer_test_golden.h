@@ -0,0 +1,225 @@
+//
+// The MIT License (MIT)
+//
+// Copyright 2013-2014 The MilkCat Project Developers
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// tokenizer_test_golden.h --- Created at 2015-03-24
+//
+// The tokens of generate_text(kGoldenSeed, kGoldenPieceNumber) in
+// tokenizer_test.cc given by the former flex scanner, src/tokenizer/token.l
+// in the history before the hand-written tokenizer. Each token is
+// {type, offset, length} and {0, 0, 0} ends a sentence. The text should be
+// scanned by that scanner again when the generator is changed
+//
+
+#ifndef TEST_TOKENIZER_TEST_GOLDEN_H_
+#define TEST_TOKENIZER_TEST_GOLDEN_H_
+
+#include <stdint.h>
+
+struct GoldenToken {
+  int type;
+  int offset;
+  int length;
+};
+
+const uint32_t kGoldenSeed = 2015;
+const int kGoldenPieceNumber = 800;
+
+const GoldenToken kGoldenTokens[] = {
+  {8, 0, 33}, {9, 33, 3}, {8, 36, 17}, {7, 53, 1}, {7, 54, 1}, {9, 55, 1},
+  {9, 56, 1}, {9, 57, 1}, {9, 60, 3}, {8, 63, 2}, {9, 65, 3}, {9, 68, 3},
+  {9, 71, 3}, {1, 74, 2}, {5, 76, 9}, {2, 85, 3}, {9, 88, 3}, {9, 91, 3},
+  {8, 94, 33}, {8, 130, 55}, {9, 185, 4}, {9, 189, 4}, {9, 193, 4},
+  {8, 197, 15}, {4, 212, 3}, {0, 0, 0}, {4, 215, 3}, {0, 0, 0}, {4, 218, 3},
+  {0, 0, 0}, {9, 221, 3}, {9, 224, 3}, {9, 227, 3}, {9, 230, 3}, {9, 233, 3},
+  {9, 237, 3}, {9, 240, 3}, {8, 243, 17}, {7, 262, 1}, {7, 263, 1},
+  {7, 264, 1}, {7, 265, 3}, {7, 268, 3}, {8, 271, 58}, {8, 333, 20},
+  {4, 353, 3}, {0, 0, 0}, {9, 356, 3}, {9, 359, 3}, {9, 362, 3}, {8, 365, 61},
+  {8, 428, 66}, {7, 494, 1}, {8, 495, 3}, {7, 498, 1}, {7, 499, 1},
+  {7, 500, 1}, {8, 501, 9}, {8, 516, 39}, {8, 563, 32}, {3, 595, 3}, {0, 0, 0},
+  {9, 598, 3}, {8, 601, 2}, {7, 603, 1}, {7, 604, 1}, {7, 605, 1}, {8, 606, 3},
+  {2, 609, 3}, {7, 612, 2}, {7, 614, 2}, {7, 616, 2}, {2, 619, 3}, {2, 622, 3},
+  {2, 625, 3}, {9, 628, 2}, {9, 630, 2}, {9, 632, 2}, {9, 634, 3}, {9, 637, 3},
+  {9, 640, 3}, {7, 643, 1}, {7, 644, 1}, {7, 645, 1}, {9, 646, 3}, {9, 649, 3},
+  {9, 652, 3}, {1, 655, 1}, {6, 656, 2}, {7, 666, 1}, {7, 667, 1}, {7, 668, 1},
+  {8, 669, 24}, {9, 693, 3}, {8, 696, 64}, {2, 760, 3}, {9, 763, 3},
+  {9, 766, 3}, {9, 769, 3}, {4, 772, 3}, {0, 0, 0}, {8, 775, 12}, {7, 787, 2},
+  {9, 789, 3}, {9, 792, 3}, {9, 795, 3}, {6, 798, 6}, {8, 807, 7}, {3, 816, 1},
+  {0, 0, 0}, {8, 817, 6}, {7, 823, 3}, {7, 826, 3}, {7, 829, 3}, {2, 832, 3},
+  {9, 835, 3}, {9, 838, 3}, {9, 841, 3}, {2, 844, 3}, {2, 847, 3}, {2, 850, 3},
+  {8, 853, 20}, {9, 873, 3}, {9, 876, 3}, {8, 879, 20}, {9, 899, 3},
+  {9, 902, 3}, {9, 905, 3}, {3, 908, 1}, {0, 0, 0}, {4, 909, 3}, {0, 0, 0},
+  {6, 912, 1}, {9, 913, 3}, {9, 916, 3}, {8, 925, 3}, {7, 928, 3}, {7, 931, 3},
+  {7, 934, 3}, {8, 937, 30}, {9, 967, 3}, {9, 970, 3}, {2, 973, 3},
+  {9, 976, 3}, {9, 979, 3}, {9, 982, 3}, {7, 985, 1}, {9, 986, 3}, {9, 989, 3},
+  {9, 992, 3}, {9, 997, 2}, {9, 999, 2}, {9, 1001, 2}, {5, 1003, 3},
+  {9, 1006, 3}, {2, 1009, 3}, {2, 1012, 3}, {2, 1015, 3}, {8, 1018, 78},
+  {7, 1099, 1}, {7, 1100, 1}, {7, 1101, 1}, {8, 1102, 70}, {7, 1172, 3},
+  {6, 1175, 2}, {2, 1177, 3}, {8, 1180, 29}, {2, 1209, 3}, {2, 1212, 3},
+  {8, 1215, 44}, {9, 1259, 1}, {9, 1260, 1}, {9, 1261, 1}, {2, 1262, 3},
+  {2, 1265, 3}, {9, 1268, 3}, {9, 1271, 3}, {6, 1274, 6}, {8, 1283, 5},
+  {9, 1288, 3}, {9, 1291, 3}, {1, 1294, 2}, {5, 1296, 6}, {9, 1302, 3},
+  {9, 1305, 3}, {7, 1308, 1}, {6, 1309, 3}, {3, 1312, 3}, {0, 0, 0},
+  {8, 1315, 21}, {4, 1336, 3}, {0, 0, 0}, {7, 1339, 3}, {8, 1343, 58},
+  {4, 1401, 3}, {0, 0, 0}, {4, 1404, 3}, {0, 0, 0}, {7, 1407, 3}, {7, 1410, 3},
+  {7, 1413, 3}, {8, 1422, 21}, {9, 1443, 3}, {9, 1446, 3}, {7, 1449, 2},
+  {7, 1451, 2}, {5, 1453, 1}, {9, 1454, 1}, {9, 1455, 1}, {9, 1456, 1},
+  {8, 1457, 23}, {9, 1486, 3}, {9, 1493, 3}, {5, 1496, 9}, {9, 1505, 3},
+  {9, 1508, 1}, {8, 1509, 27}, {4, 1536, 3}, {0, 0, 0}, {5, 1539, 1},
+  {4, 1540, 3}, {0, 0, 0}, {4, 1543, 3}, {0, 0, 0}, {6, 1546, 12},
+  {9, 1558, 3}, {9, 1561, 3}, {9, 1564, 3}, {9, 1567, 1}, {8, 1568, 6},
+  {9, 1574, 3}, {9, 1577, 3}, {9, 1580, 3}, {9, 1583, 1}, {2, 1584, 3},
+  {2, 1587, 3}, {2, 1590, 3}, {2, 1595, 3}, {9, 1598, 3}, {9, 1601, 3},
+  {2, 1604, 3}, {2, 1607, 3}, {8, 1610, 113}, {8, 1725, 10}, {2, 1735, 3},
+  {2, 1738, 3}, {2, 1741, 3}, {8, 1744, 16}, {9, 1760, 3}, {8, 1763, 82},
+  {8, 1849, 22}, {7, 1871, 1}, {7, 1884, 3}, {7, 1887, 3}, {8, 1890, 38},
+  {9, 1928, 4}, {1, 1932, 2}, {7, 1934, 1}, {7, 1935, 1}, {8, 1936, 3},
+  {9, 1939, 3}, {9, 1942, 3}, {9, 1945, 3}, {8, 1948, 27}, {9, 1975, 3},
+  {9, 1978, 3}, {9, 1981, 3}, {6, 1984, 9}, {4, 1993, 3}, {0, 0, 0},
+  {4, 1996, 3}, {0, 0, 0}, {4, 1999, 3}, {0, 0, 0}, {9, 2002, 4}, {9, 2006, 4},
+  {8, 2010, 17}, {5, 2030, 6}, {8, 2039, 16}, {2, 2055, 3}, {2, 2058, 3},
+  {6, 2061, 9}, {5, 2074, 6}, {9, 2080, 3}, {9, 2083, 3}, {6, 2086, 15},
+  {7, 2101, 3}, {7, 2104, 3}, {7, 2107, 3}, {7, 2110, 1}, {8, 2112, 26},
+  {7, 2138, 1}, {1, 2140, 2}, {7, 2142, 1}, {8, 2143, 3}, {4, 2146, 3},
+  {0, 0, 0}, {4, 2149, 3}, {0, 0, 0}, {4, 2152, 3}, {0, 0, 0}, {8, 2155, 22},
+  {1, 2177, 3}, {7, 2180, 1}, {7, 2181, 1}, {9, 2184, 3}, {4, 2187, 3},
+  {0, 0, 0}, {4, 2190, 3}, {0, 0, 0}, {1, 2193, 3}, {9, 2196, 3}, {9, 2199, 3},
+  {9, 2202, 3}, {6, 2207, 9}, {9, 2216, 2}, {9, 2218, 2}, {7, 2220, 1},
+  {3, 2226, 2}, {0, 0, 0}, {2, 2228, 3}, {2, 2231, 3}, {2, 2234, 3},
+  {9, 2237, 3}, {9, 2240, 3}, {8, 2243, 6}, {2, 2249, 3}, {6, 2252, 2},
+  {8, 2256, 5}, {3, 2261, 3}, {0, 0, 0}, {1, 2264, 2}, {8, 2266, 46},
+  {7, 2312, 1}, {7, 2313, 1}, {6, 2314, 1}, {9, 2315, 3}, {8, 2318, 11},
+  {9, 2329, 3}, {9, 2332, 3}, {9, 2335, 3}, {9, 2338, 3}, {9, 2341, 3},
+  {4, 2350, 3}, {0, 0, 0}, {4, 2353, 3}, {0, 0, 0}, {7, 2356, 2}, {7, 2358, 2},
+  {7, 2360, 2}, {7, 2363, 2}, {9, 2365, 3}, {9, 2368, 3}, {9, 2377, 3},
+  {9, 2380, 3}, {7, 2383, 1}, {8, 2386, 70}, {7, 2456, 3}, {7, 2459, 3},
+  {1, 2465, 1}, {3, 2466, 2}, {0, 0, 0}, {7, 2469, 3}, {7, 2472, 3},
+  {7, 2475, 3}, {7, 2478, 3}, {8, 2483, 139}, {2, 2622, 3}, {2, 2625, 3},
+  {8, 2628, 50}, {5, 2680, 6}, {4, 2686, 3}, {0, 0, 0}, {4, 2689, 3},
+  {0, 0, 0}, {4, 2692, 3}, {0, 0, 0}, {9, 2695, 3}, {9, 2698, 3}, {9, 2701, 3},
+  {2, 2710, 3}, {2, 2713, 3}, {2, 2716, 3}, {9, 2722, 3}, {9, 2725, 3},
+  {9, 2728, 3}, {9, 2731, 3}, {9, 2734, 3}, {7, 2737, 3}, {9, 2743, 3},
+  {8, 2746, 48}, {2, 2794, 3}, {2, 2797, 3}, {9, 2800, 3}, {9, 2803, 3},
+  {9, 2806, 3}, {7, 2809, 1}, {9, 2810, 3}, {2, 2813, 3}, {8, 2816, 33},
+  {8, 2852, 2}, {9, 2854, 3}, {9, 2857, 3}, {9, 2860, 3}, {7, 2863, 3},
+  {7, 2866, 1}, {7, 2867, 1}, {7, 2868, 1}, {9, 2869, 4}, {9, 2873, 3},
+  {8, 2876, 13}, {9, 2891, 3}, {8, 2894, 60}, {2, 2954, 3}, {2, 2957, 3},
+  {2, 2960, 3}, {1, 2963, 1}, {2, 2964, 3}, {2, 2967, 3}, {7, 2970, 3},
+  {7, 2973, 3}, {7, 2976, 3}, {8, 2979, 30}, {9, 3015, 3}, {9, 3018, 3},
+  {8, 3021, 37}, {4, 3058, 3}, {0, 0, 0}, {4, 3061, 3}, {0, 0, 0},
+  {9, 3066, 3}, {9, 3069, 3}, {9, 3072, 3}, {7, 3075, 3}, {5, 3078, 3},
+  {9, 3081, 3}, {6, 3084, 1}, {7, 3085, 2}, {7, 3087, 2}, {3, 3089, 1},
+  {0, 0, 0}, {8, 3090, 2}, {9, 3092, 3}, {9, 3095, 3}, {8, 3098, 36},
+  {4, 3134, 3}, {0, 0, 0}, {4, 3137, 3}, {0, 0, 0}, {4, 3140, 3}, {0, 0, 0},
+  {8, 3149, 17}, {2, 3166, 3}, {2, 3169, 3}, {2, 3172, 3}, {8, 3175, 34},
+  {7, 3209, 2}, {7, 3211, 2}, {7, 3213, 2}, {8, 3215, 10}, {9, 3225, 3},
+  {5, 3228, 3}, {9, 3231, 3}, {8, 3234, 19}, {9, 3253, 3}, {9, 3256, 3},
+  {8, 3259, 23}, {1, 3282, 2}, {8, 3284, 36}, {8, 3332, 6}, {2, 3338, 3},
+  {2, 3341, 3}, {2, 3344, 3}, {2, 3347, 3}, {2, 3350, 3}, {6, 3353, 9},
+  {8, 3363, 14}, {7, 3377, 1}, {7, 3378, 1}, {7, 3379, 1}, {8, 3380, 53},
+  {7, 3433, 1}, {8, 3435, 20}, {9, 3455, 3}, {9, 3458, 3}, {4, 3461, 3},
+  {0, 0, 0}, {4, 3464, 3}, {0, 0, 0}, {6, 3467, 6}, {9, 3473, 3}, {9, 3476, 3},
+  {7, 3479, 1}, {7, 3480, 1}, {7, 3481, 1}, {7, 3482, 1}, {9, 3483, 3},
+  {9, 3486, 3}, {8, 3489, 33}, {8, 3530, 14}, {4, 3544, 3}, {0, 0, 0},
+  {2, 3547, 3}, {9, 3550, 3}, {6, 3553, 15}, {9, 3568, 3}, {9, 3571, 3},
+  {9, 3574, 3}, {8, 3577, 14}, {5, 3593, 3}, {9, 3596, 3}, {9, 3599, 3},
+  {9, 3602, 3}, {6, 3605, 18}, {4, 3623, 3}, {0, 0, 0}, {4, 3626, 3},
+  {0, 0, 0}, {8, 3629, 38}, {7, 3667, 1}, {7, 3668, 1}, {9, 3669, 3},
+  {9, 3672, 3}, {3, 3675, 1}, {0, 0, 0}, {6, 3682, 6}, {9, 3688, 3},
+  {9, 3691, 3}, {9, 3694, 3}, {1, 3697, 2}, {7, 3699, 1}, {7, 3700, 1},
+  {7, 3701, 1}, {7, 3702, 1}, {7, 3703, 1}, {9, 3704, 2}, {9, 3706, 2},
+  {9, 3708, 2}, {9, 3710, 3}, {9, 3713, 3}, {8, 3716, 21}, {3, 3737, 2},
+  {0, 0, 0}, {8, 3739, 39}, {7, 3780, 2}, {9, 3782, 3}, {9, 3785, 3},
+  {9, 3788, 3}, {7, 3791, 1}, {7, 3792, 1}, {7, 3793, 1}, {7, 3794, 1},
+  {8, 3795, 32}, {7, 3827, 3}, {7, 3830, 3}, {7, 3833, 3}, {9, 3836, 3},
+  {9, 3839, 3}, {9, 3842, 3}, {5, 3845, 1}, {8, 3859, 6}, {1, 3865, 1},
+  {8, 3866, 46}, {9, 3915, 3}, {9, 3918, 3}, {8, 3921, 15}, {9, 3936, 3},
+  {9, 3939, 4}, {9, 3943, 4}, {9, 3947, 4}, {2, 3951, 3}, {2, 3954, 3},
+  {2, 3957, 3}, {8, 3960, 22}, {8, 3986, 40}, {8, 4034, 23}, {9, 4057, 2},
+  {8, 4059, 36}, {9, 4095, 4}, {9, 4099, 4}, {9, 4103, 4}, {8, 4107, 16},
+  {9, 4123, 4}, {9, 4127, 4}, {8, 4131, 16}, {9, 4147, 3}, {4, 4150, 3},
+  {0, 0, 0}, {4, 4153, 3}, {0, 0, 0}, {9, 4156, 3}, {9, 4159, 4}, {9, 4163, 4},
+  {4, 4167, 3}, {0, 0, 0}, {4, 4170, 3}, {0, 0, 0}, {4, 4173, 3}, {0, 0, 0},
+  {8, 4176, 25}, {7, 4201, 3}, {7, 4204, 3}, {7, 4207, 3}, {7, 4210, 3},
+  {7, 4213, 3}, {7, 4216, 3}, {7, 4219, 3}, {8, 4222, 3}, {7, 4225, 3},
+  {2, 4228, 3}, {8, 4231, 137}, {8, 4370, 67}, {7, 4437, 3}, {7, 4440, 3},
+  {7, 4443, 3}, {2, 4446, 3}, {4, 4457, 3}, {0, 0, 0}, {4, 4460, 3}, {0, 0, 0},
+  {4, 4463, 3}, {0, 0, 0}, {1, 4466, 2}, {8, 4468, 18}, {1, 4486, 1},
+  {9, 4487, 3}, {9, 4490, 4}, {9, 4494, 4}, {9, 4498, 4}, {4, 4502, 3},
+  {0, 0, 0}, {8, 4505, 53}, {9, 4560, 3}, {9, 4563, 3}, {9, 4566, 3},
+  {9, 4569, 1}, {4, 4574, 3}, {0, 0, 0}, {4, 4577, 3}, {0, 0, 0}, {4, 4580, 3},
+  {0, 0, 0}, {1, 4583, 1}, {9, 4584, 3}, {9, 4587, 3}, {9, 4590, 3},
+  {2, 4597, 3}, {2, 4600, 3}, {2, 4603, 3}, {8, 4606, 36}, {9, 4642, 3},
+  {9, 4645, 3}, {8, 4648, 16}, {8, 4666, 25}, {2, 4695, 3}, {2, 4698, 3},
+  {8, 4704, 25}, {9, 4730, 3}, {9, 4733, 3}, {9, 4736, 3}, {6, 4739, 1},
+  {1, 4740, 1}, {3, 4741, 3}, {0, 0, 0}, {9, 4744, 3}, {9, 4747, 3},
+  {9, 4750, 3}, {8, 4755, 13}, {2, 4768, 3}, {9, 4771, 3}, {9, 4774, 3},
+  {7, 4777, 3}, {8, 4780, 31}, {7, 4811, 3}, {7, 4814, 3}, {9, 4817, 3},
+  {8, 4820, 3}, {1, 4823, 4}, {8, 4827, 8}, {9, 4835, 3}, {7, 4838, 3},
+  {7, 4841, 3}, {6, 4844, 6}, {8, 4852, 37}, {2, 4889, 3}, {8, 4892, 43},
+  {4, 4938, 3}, {0, 0, 0}, {4, 4941, 3}, {0, 0, 0}, {9, 4944, 3}, {9, 4947, 3},
+  {8, 4950, 64}, {3, 5014, 5}, {0, 0, 0}, {8, 5019, 24}, {2, 5043, 3},
+  {2, 5046, 3}, {2, 5049, 3}, {8, 5052, 33}, {7, 5085, 3}, {7, 5088, 3},
+  {7, 5091, 3}, {8, 5094, 20}, {7, 5117, 3}, {7, 5120, 3}, {7, 5123, 3},
+  {9, 5126, 3}, {9, 5129, 3}, {9, 5132, 3}, {8, 5135, 30}, {7, 5165, 3},
+  {8, 5168, 70}, {9, 5238, 1}, {8, 5239, 42}, {5, 5282, 2}, {2, 5284, 3},
+  {2, 5287, 3}, {2, 5290, 3}, {7, 5293, 3}, {7, 5296, 3}, {7, 5299, 3},
+  {9, 5302, 3}, {9, 5305, 3}, {9, 5308, 3}, {8, 5311, 65}, {7, 5376, 2},
+  {9, 5378, 3}, {9, 5381, 3}, {9, 5384, 3}, {8, 5388, 4}, {9, 5392, 3},
+  {9, 5395, 3}, {8, 5411, 19}, {9, 5430, 1}, {9, 5431, 1}, {9, 5432, 3},
+  {8, 5435, 28}, {1, 5463, 3}, {8, 5466, 19}, {8, 5499, 3}, {9, 5502, 3},
+  {2, 5505, 3}, {2, 5508, 3}, {9, 5511, 3}, {9, 5514, 3}, {9, 5517, 3},
+  {8, 5520, 2}, {4, 5522, 3}, {0, 0, 0}, {4, 5525, 3}, {0, 0, 0}, {4, 5528, 3},
+  {0, 0, 0}, {8, 5531, 4}, {9, 5535, 1}, {9, 5536, 1}, {9, 5537, 1},
+  {8, 5542, 27}, {2, 5569, 3}, {2, 5572, 3}, {8, 5575, 119}, {9, 5694, 3},
+  {9, 5697, 3}, {9, 5700, 3}, {8, 5703, 71}, {4, 5774, 3}, {0, 0, 0},
+  {4, 5777, 3}, {0, 0, 0}, {4, 5780, 3}, {0, 0, 0}, {2, 5783, 3}, {2, 5786, 3},
+  {5, 5789, 6}, {9, 5795, 3}, {1, 5798, 3}, {8, 5801, 38}, {4, 5839, 3},
+  {0, 0, 0}, {4, 5842, 3}, {0, 0, 0}, {8, 5845, 40}, {9, 5885, 3},
+  {9, 5888, 3}, {9, 5891, 3}, {7, 5894, 3}, {7, 5897, 3}, {7, 5900, 3},
+  {2, 5903, 3}, {2, 5906, 3}, {2, 5909, 3}, {8, 5912, 25}, {9, 5937, 3},
+  {1, 5940, 2}, {8, 5942, 10}, {2, 5952, 3}, {2, 5955, 3}, {8, 5958, 9},
+  {9, 5967, 3}, {7, 5970, 3}, {7, 5973, 3}, {8, 5976, 30}, {9, 6006, 3},
+  {9, 6009, 3}, {9, 6012, 3}, {8, 6015, 4}, {1, 6019, 1}, {9, 6020, 3},
+  {9, 6023, 3}, {9, 6026, 3}, {8, 6029, 47}, {4, 6077, 3}, {0, 0, 0},
+  {7, 6080, 3}, {2, 6083, 3}, {2, 6086, 3}, {2, 6089, 3}, {7, 6092, 1},
+  {7, 6093, 2}, {7, 6095, 2}, {9, 6097, 3}, {8, 6100, 33}, {8, 6136, 44},
+  {5, 6183, 2}, {9, 6185, 2}, {9, 6187, 2}, {9, 6189, 2}, {4, 6191, 3},
+  {0, 0, 0}, {8, 6194, 28}, {4, 6222, 3}, {0, 0, 0}, {4, 6225, 3}, {0, 0, 0},
+  {4, 6228, 3}, {0, 0, 0}, {7, 6231, 1}, {8, 6232, 3}, {9, 6235, 3},
+  {6, 6242, 1}, {9, 6243, 3}, {9, 6246, 3}, {9, 6249, 3}, {1, 6252, 3},
+  {3, 6255, 1}, {0, 0, 0}, {8, 6256, 49}, {8, 6308, 35}, {4, 6349, 3},
+  {0, 0, 0}, {4, 6352, 3}, {0, 0, 0}, {2, 6355, 3}, {8, 6358, 33},
+  {9, 6391, 4}, {7, 6395, 1}, {8, 6397, 18}, {9, 6415, 4}, {2, 6419, 3},
+  {9, 6422, 3}, {8, 6425, 37}, {7, 6462, 3}, {7, 6465, 3}, {7, 6468, 3},
+  {2, 6481, 3}, {2, 6484, 3}, {2, 6487, 3}, {9, 6490, 3}, {9, 6493, 3},
+  {8, 6496, 39}, {7, 6535, 3}, {7, 6538, 3}, {7, 6541, 3}, {2, 6544, 3},
+  {7, 6547, 3}, {7, 6550, 3}, {7, 6553, 3}, {7, 6556, 2}, {8, 6558, 38},
+  {9, 6596, 3}, {9, 6599, 3}, {9, 6602, 3}, {8, 6605, 10}, {6, 6619, 6},
+  {7, 6625, 1}, {7, 6626, 2}, {8, 6628, 42}, {1, 6670, 2}, {8, 6672, 40},
+  {7, 6712, 3}, {7, 6715, 3}, {9, 6718, 3}, {8, 6721, 5}, {9, 6726, 3},
+  {7, 6729, 1}, {7, 6730, 1}, {7, 6731, 2}, {9, 6733, 3}, {5, 6736, 12},
+  {9, 6748, 4}, {9, 6752, 4}, {9, 6756, 4}, {8, 6760, 23}, {7, 6783, 3},
+  {7, 6786, 3}, {7, 6789, 3}, {0, 0, 0}
+};
+
+#endif  // TEST_TOKENIZER_TEST_GOLDEN_H_
@@ -0,0 +1,198 @@
+//
+// The MIT License (MIT)
+//
+// Copyright 2013-2014 The MilkCat Project Developers
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+// viterbi_kernel_test.cc --- Created at 2015-03-14
+//
+
+#include "ml/viterbi_kernel.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <vector>
+
+using milkcat::MaxPlus;
+using milkcat::ViterbiKernelSupported;
+
+// Generates a random cost, some of them are -inf (disallowed) or small
+// integers (to make ties)
+double random_cost() {
+  int r = rand() % 10;
+  if (r == 0) return -HUGE_VAL;
+  if (r < 4) return static_cast<double>(rand() % 3);
+  return (rand() - RAND_MAX / 2) / 1e5;
+}
+
+// Checks that `kernel` gives exactly the same result as the scalar kernel
+// with cost type `T`
+template<typename T>
+void check_kernel(int kernel) {
+  for (int size = 1; size <= 40; ++size) {
+    int stride = (size + milkcat::kViterbiKernelAlign - 1) /
+                 milkcat::kViterbiKernelAlign * milkcat::kViterbiKernelAlign;
+    std::vector<T> prev_cost(stride), matrix(size * stride);
+    std::vector<T> expected_cost(stride), cost(stride);
+    std::vector<int> expected_left(stride), left(stride);
+
+    for (int i = 0; i < size; ++i) {
+      prev_cost[i] = static_cast<T>(random_cost());
+    }
+    for (int i = 0; i < size; ++i) {
+      for (int j = 0; j < stride; ++j) {
+        matrix[i * stride + j] = static_cast<T>(
+            j < size? random_cost(): -HUGE_VAL);
+      }
+    }
+
+    MaxPlus(milkcat::kScalarViterbiKernel,
+            &prev_cost[0],
+            &matrix[0],
+            size,
+            stride,
+            &expected_cost[0],
+            &expected_left[0]);
+    MaxPlus(kernel,
+            &prev_cost[0],
+            &matrix[0],
+            size,
+            stride,
+            &cost[0],
+            &left[0]);
+    for (int j = 0; j < size; ++j) {
+      assert(expected_cost[j] == cost[j]);
+      assert(expected_left[j] == left[j]);
+    }
+  }
+}
+
+// The tolerance of costs summed in different order, relative to the sum of
+// absolute values of the added costs
+template<typename T> double sum_order_tolerance();
+template<> double sum_order_tolerance<double>() { return 1e-12; }
+template<> double sum_order_tolerance<float>() { return 1e-5; }
+
+// Checks `kernel` with the matrix summed from `feature_num` bigram features
+// (as CRFTagger does) against the per-feature loop of the original Viterbi,
+// which adds the features to the previous cost one by one. With a single
+// feature the results are exactly the same. Otherwise the addition order is
+// changed from (prev + b1) + b2 to prev + (b1 + b2), so the costs are only
+// equal within the rounding error, and a different left could be chosen
+// only when it is tied with the original one within the same error
+template<typename T>
+void check_feature_sum(int kernel, int feature_num) {
+  for (int size = 1; size <= 40; ++size) {
+    int stride = (size + milkcat::kViterbiKernelAlign - 1) /
+                 milkcat::kViterbiKernelAlign * milkcat::kViterbiKernelAlign;
+    std::vector<T> prev_cost(stride), matrix(size * stride);
+    std::vector<T> features(feature_num * size * size);
+    std::vector<bool> allowed(size * size);
+    std::vector<T> cost(stride);
+    std::vector<int> left(stride);
+
+    for (int i = 0; i < size; ++i) {
+      prev_cost[i] = static_cast<T>(random_cost());
+    }
+    for (int i = 0; i < size * size; ++i) allowed[i] = rand() % 8 != 0;
+    for (size_t i = 0; i < features.size(); ++i) {
+      features[i] = static_cast<T>((rand() - RAND_MAX / 2) / 1e5);
+    }
+
+    // The matrix is built like CRFTagger::BuildBigramMatrix
+    for (int i = 0; i < size; ++i) {
+      for (int j = 0; j < stride; ++j) {
+        if (j < size && allowed[i * size + j]) {
+          matrix[i * stride + j] = 0;
+          for (int f = 0; f < feature_num; ++f) {
+            matrix[i * stride + j] += features[(f * size + i) * size + j];
+          }
+        } else {
+          matrix[i * stride + j] = static_cast<T>(-HUGE_VAL);
+        }
+      }
+    }
+    MaxPlus(kernel,
+            &prev_cost[0],
+            &matrix[0],
+            size,
+            stride,
+            &cost[0],
+            &left[0]);
+
+    for (int j = 0; j < size; ++j) {
+      // The original per-feature loop. `magnitude` is the largest sum of
+      // absolute values of the added costs, the rounding error is relative
+      // to it
+      std::vector<T> original_cost(size, static_cast<T>(-HUGE_VAL));
+      T best_cost = static_cast<T>(-1e37);
+      int best_left = 0;
+      double magnitude = 1.0;
+      for (int i = 0; i < size; ++i) {
+        if (!allowed[i * size + j]) continue;
+        T c = prev_cost[i];
+        double sum = fabs(static_cast<double>(prev_cost[i]));
+        for (int f = 0; f < feature_num; ++f) {
+          c += features[(f * size + i) * size + j];
+          sum += fabs(static_cast<double>(features[(f * size + i) * size + j]));
+        }
+        if (sum < HUGE_VAL) magnitude = std::max(magnitude, sum);
+        original_cost[i] = c;
+        if (c > best_cost) {
+          best_cost = c;
+          best_left = i;
+        }
+      }
+
+      if (feature_num == 1) {
+        assert(cost[j] == best_cost);
+        assert(left[j] == best_left);
+      } else {
+        double tolerance = sum_order_tolerance<T>() * magnitude;
+        assert(fabs(static_cast<double>(cost[j]) - best_cost) <= tolerance);
+        if (left[j] != best_left) {
+          assert(best_cost - original_cost[left[j]] <= tolerance);
+        }
+      }
+    }
+  }
+}
+
+int main() {
+  int kernels[] = {milkcat::kAutoViterbiKernel,
+                   milkcat::kSSE2ViterbiKernel,
+                   milkcat::kAVX2ViterbiKernel};
+  for (int i = 0; i < 3; ++i) {
+    if (ViterbiKernelSupported(kernels[i])) {
+      for (int n = 0; n < 100; ++n) {
+        check_kernel<double>(kernels[i]);
+        check_kernel<float>(kernels[i]);
+        for (int feature_num = 1; feature_num <= 3; ++feature_num) {
+          check_feature_sum<double>(kernels[i], feature_num);
+          check_feature_sum<float>(kernels[i], feature_num);
+        }
+      }
+      printf("kernel %d OK\n", kernels[i]);
+    }
+  }
+  return 0;
+}